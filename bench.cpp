@@ -0,0 +1,437 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <filesystem>
+#include <algorithm>
+#include <iomanip>
+#include <optional>
+
+#include "hypercuboid.h"
+#include "pgnparser.h"
+#include "magic.h"
+
+/*
+ Benchmark for legal action enumeration.
+ For every position, it measures (over a number of repetitions):
+  - load:     parsing the 5dpgn and replaying all moves into a `state`
+  - build_HC: HC_info::build_HC()
+  - search:   draining HC_info::search() (capped by --max)
+ and optionally a perft count of depth N, which recurses through state::can_apply(action).
+ With --sliders, it instead measures the time per call of every slider attack backend.
+ Reported times are the minimum and the median over all repetitions, which are
+ far more stable than the mean for short runs.
+ */
+
+using clock_type = std::chrono::steady_clock;
+
+static double elapsed_ms(clock_type::time_point start, clock_type::time_point end)
+{
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+struct timing
+{
+    std::vector<double> samples;
+    double min() const
+    {
+        return samples.empty() ? 0 : *std::min_element(samples.begin(), samples.end());
+    }
+    double median() const
+    {
+        if(samples.empty())
+            return 0;
+        std::vector<double> s = samples;
+        std::sort(s.begin(), s.end());
+        size_t n = s.size();
+        return n % 2 ? s[n/2] : (s[n/2 - 1] + s[n/2]) / 2;
+    }
+};
+
+struct bench_result
+{
+    std::string name;
+    std::optional<std::string> error;
+    timing load, build, search;
+    uint64_t actions = 0;
+    bool capped = false;
+    int perft_depth = 0;
+    uint64_t perft_nodes = 0;
+    double perft_ms = 0;
+
+    double actions_per_second() const
+    {
+        double t = build.median() + search.median();
+        return t > 0 ? actions / t * 1000 : 0;
+    }
+};
+
+action to_action(const moveseq &mvs, const state &s)
+{
+    std::vector<ext_move> emvs(mvs.begin(), mvs.end());
+    return action::from_vector(emvs, s);
+}
+
+/*
+ perft(s, depth): number of distinct action sequences of length `depth` starting from `s`
+ */
+uint64_t perft(const state &s, int depth)
+{
+    if(depth <= 0)
+        return 1;
+    auto [w, ss] = HC_info::build_HC(s);
+    uint64_t nodes = 0;
+    for(const moveseq &mvs : w.search(ss))
+    {
+        if(depth == 1)
+        {
+            nodes++;
+            continue;
+        }
+        std::optional<state> t = s.can_apply(to_action(mvs, s));
+        if(!t)
+        {
+            throw std::runtime_error("perft: search produced an action rejected by can_apply()");
+        }
+        nodes += perft(*t, depth - 1);
+    }
+    return nodes;
+}
+
+bench_result run_bench(const std::filesystem::path &path, int reps, uint64_t max, int depth, int threads)
+{
+    bench_result r;
+    r.name = path.filename().string();
+    std::ifstream in(path);
+    std::ostringstream buffer;
+    buffer << in.rdbuf();
+    std::string pgn = buffer.str();
+    try {
+        std::optional<state> s;
+        for(int i = 0; i < reps; i++)
+        {
+            auto start = clock_type::now();
+            s.emplace(*pgnparser(pgn).parse_game());
+            r.load.samples.push_back(elapsed_ms(start, clock_type::now()));
+        }
+        for(int i = 0; i < reps; i++)
+        {
+            auto start = clock_type::now();
+            auto [w, ss] = HC_info::build_HC(*s);
+            auto mid = clock_type::now();
+            uint64_t count = 0;
+            // only the sequential enumeration stops at --max
+            bool capped = false;
+            if(threads >= 0)
+            {
+                count = w.search_parallel(ss, threads, false).size();
+            }
+            else
+            {
+                for([[maybe_unused]] const moveseq &mvs : w.search(ss))
+                {
+                    // capped only if there is an action beyond the first `max` ones
+                    if(max && count == max)
+                    {
+                        capped = true;
+                        break;
+                    }
+                    count++;
+                }
+            }
+            auto end = clock_type::now();
+            r.build.samples.push_back(elapsed_ms(start, mid));
+            r.search.samples.push_back(elapsed_ms(mid, end));
+            r.actions = count;
+            r.capped = capped;
+        }
+        if(depth > 0)
+        {
+            auto start = clock_type::now();
+            r.perft_depth = depth;
+            r.perft_nodes = perft(*s, depth);
+            r.perft_ms = elapsed_ms(start, clock_type::now());
+        }
+    } catch (const std::exception &e) {
+        r.error = e.what();
+    }
+    return r;
+}
+
+/*
+ slider_bench(backend, calls): nanoseconds per rook_attack() + bishop_attack() pair, over
+ pseudo-random squares and sparse blockers that are generated before timing
+ */
+double slider_bench(slider_backend backend, size_t calls)
+{
+    constexpr size_t n = 4096;
+    std::vector<std::pair<int, bitboard_t>> inputs(n);
+    uint64_t x = 0x9e3779b97f4a7c15ull;
+    for(auto &[pos, blocker] : inputs)
+    {
+        x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+        pos = x % BOARD_SIZE;
+        blocker = x;
+        x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+        blocker &= x;
+    }
+    slider_backend previous = get_slider_backend();
+    set_slider_backend(backend);
+    bitboard_t sink = 0;
+    auto start = clock_type::now();
+    for(size_t i = 0; i < calls; i++)
+    {
+        auto [pos, blocker] = inputs[i % n];
+        sink ^= rook_attack(pos, blocker ^ sink) ^ bishop_attack(pos, blocker);
+    }
+    auto end = clock_type::now();
+    set_slider_backend(previous);
+    // keep the loop from being optimized away
+    volatile bitboard_t result = sink;
+    (void)result;
+    return elapsed_ms(start, end) * 1e6 / calls;
+}
+
+void print_slider_bench(const std::string &format, int reps)
+{
+    constexpr size_t calls = 1 << 22;
+    std::vector<std::pair<slider_backend, timing>> results;
+    for(slider_backend backend : supported_slider_backends())
+    {
+        timing t;
+        for(int i = 0; i < reps; i++)
+        {
+            t.samples.push_back(slider_bench(backend, calls));
+        }
+        results.emplace_back(backend, std::move(t));
+    }
+    std::cout << std::fixed << std::setprecision(4);
+    if(format == "json")
+    {
+        std::cout << "{\n  \"repetitions\": " << reps
+                  << ",\n  \"default\": \"" << slider_backend_name(get_slider_backend()) << "\""
+                  << ",\n  \"sliders\": [";
+        bool first = true;
+        for(const auto &[backend, t] : results)
+        {
+            std::cout << (first ? "\n" : ",\n");
+            first = false;
+            std::cout << "    {\"backend\": \"" << slider_backend_name(backend) << "\""
+                      << ", \"ns_per_call\": {\"min\": " << t.min() << ", \"median\": " << t.median() << "}}";
+        }
+        std::cout << "\n  ]\n}" << std::endl;
+    }
+    else
+    {
+        std::cout << "backend,ns_per_call_min,ns_per_call_median\n";
+        for(const auto &[backend, t] : results)
+        {
+            std::cout << slider_backend_name(backend) << "," << t.min() << "," << t.median() << "\n";
+        }
+    }
+}
+
+std::string json_escape(const std::string &str)
+{
+    std::ostringstream oss;
+    for(char c : str)
+    {
+        switch(c)
+        {
+            case '"': oss << "\\\""; break;
+            case '\\': oss << "\\\\"; break;
+            case '\n': oss << "\\n"; break;
+            case '\t': oss << "\\t"; break;
+            default:
+                if(static_cast<unsigned char>(c) < 0x20)
+                    oss << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec << std::setfill(' ');
+                else
+                    oss << c;
+        }
+    }
+    return oss.str();
+}
+
+void print_json(const std::vector<bench_result> &results, int reps)
+{
+    std::cout << std::fixed << std::setprecision(4);
+    std::cout << "{\n  \"repetitions\": " << reps << ",\n  \"results\": [";
+    bool first = true;
+    for(const auto &r : results)
+    {
+        std::cout << (first ? "\n" : ",\n");
+        first = false;
+        std::cout << "    {\"file\": \"" << json_escape(r.name) << "\"";
+        if(r.error)
+        {
+            std::cout << ", \"error\": \"" << json_escape(*r.error) << "\"}";
+            continue;
+        }
+        std::cout << ", \"actions\": " << r.actions
+                  << ", \"capped\": " << (r.capped ? "true" : "false")
+                  << ", \"load_ms\": {\"min\": " << r.load.min() << ", \"median\": " << r.load.median() << "}"
+                  << ", \"build_hc_ms\": {\"min\": " << r.build.min() << ", \"median\": " << r.build.median() << "}"
+                  << ", \"search_ms\": {\"min\": " << r.search.min() << ", \"median\": " << r.search.median() << "}"
+                  << ", \"actions_per_second\": " << r.actions_per_second();
+        if(r.perft_depth > 0)
+        {
+            std::cout << ", \"perft\": {\"depth\": " << r.perft_depth
+                      << ", \"nodes\": " << r.perft_nodes
+                      << ", \"ms\": " << r.perft_ms << "}";
+        }
+        std::cout << "}";
+    }
+    std::cout << "\n  ]\n}" << std::endl;
+}
+
+void print_csv(const std::vector<bench_result> &results)
+{
+    std::cout << std::fixed << std::setprecision(4);
+    std::cout << "file,actions,capped,load_ms_min,load_ms_median,build_hc_ms_min,build_hc_ms_median,"
+                 "search_ms_min,search_ms_median,actions_per_second,perft_depth,perft_nodes,perft_ms,error\n";
+    for(const auto &r : results)
+    {
+        std::cout << r.name << ",";
+        if(r.error)
+        {
+            std::string err = *r.error;
+            std::replace(err.begin(), err.end(), '"', '\'');
+            std::replace(err.begin(), err.end(), '\n', ' ');
+            std::cout << ",,,,,,,,,,,,\"" << err << "\"\n";
+            continue;
+        }
+        std::cout << r.actions << "," << (r.capped ? 1 : 0) << ","
+                  << r.load.min() << "," << r.load.median() << ","
+                  << r.build.min() << "," << r.build.median() << ","
+                  << r.search.min() << "," << r.search.median() << ","
+                  << r.actions_per_second() << ","
+                  << r.perft_depth << "," << r.perft_nodes << "," << r.perft_ms << ",\n";
+    }
+}
+
+std::string helpmsg = R"(usage: bench [options] [<file-or-directory>...]
+where [options] are:
+  --reps <n>        number of repetitions per position (default: 5)
+  --max <n>         stop enumerating after <n> actions (default: 10000, 0 means no cap)
+  --perft <n>       also count action sequences of depth <n> (default: 0, disabled)
+  --threads <n>     enumerate with HC_info::search_parallel on <n> threads (0 means all hardware threads);
+                    --max is ignored in this mode (default: sequential HC_info::search)
+  --format <fmt>    output format, one of json, csv (default: json)
+  --slider-backend <name>
+                    slider attack backend, one of plain_magic, fancy_magic, pext, kogge_stone
+                    (default: pext if the CPU supports it, fancy_magic otherwise)
+  --sliders         only compare the time per call of all supported slider attack backends
+  help              print this message
+every directory is scanned for *.5dpgn files; default input is the directory `pgn`
+)";
+
+int main(int argc, const char *argv[])
+{
+    int reps = 5, depth = 0, threads = -1;
+    uint64_t max = 10000;
+    std::string format = "json";
+    bool sliders = false;
+    std::vector<std::filesystem::path> inputs;
+    try {
+        for(int i = 1; i < argc; i++)
+        {
+            std::string arg = argv[i];
+            auto next = [&]() -> std::string {
+                if(i + 1 >= argc)
+                    throw std::invalid_argument("missing value after " + arg);
+                return argv[++i];
+            };
+            if(arg == "help" || arg == "--help")
+            {
+                std::cout << helpmsg;
+                return 0;
+            }
+            else if(arg == "--reps")
+                reps = std::max(1, std::stoi(next()));
+            else if(arg == "--max")
+                max = std::stoull(next());
+            else if(arg == "--perft")
+                depth = std::stoi(next());
+            else if(arg == "--threads")
+                threads = std::max(0, std::stoi(next()));
+            else if(arg == "--format")
+                format = next();
+            else if(arg == "--slider-backend")
+            {
+                std::string name = next();
+                auto backends = {slider_backend::PLAIN_MAGIC, slider_backend::FANCY_MAGIC, slider_backend::PEXT, slider_backend::KOGGE_STONE};
+                auto it = std::find_if(backends.begin(), backends.end(), [&name](slider_backend b) {
+                    return name == slider_backend_name(b);
+                });
+                if(it == backends.end())
+                    throw std::invalid_argument("unknown slider backend " + name);
+                set_slider_backend(*it);
+            }
+            else if(arg == "--sliders")
+                sliders = true;
+            else
+                inputs.push_back(arg);
+        }
+    } catch (const std::exception &e) {
+        std::cerr << "Bad argument: " << e.what() << std::endl;
+        std::cout << helpmsg;
+        return 2;
+    }
+    if(format != "json" && format != "csv")
+    {
+        std::cerr << "Unknown format: " << format << std::endl;
+        return 2;
+    }
+    if(sliders)
+    {
+        print_slider_bench(format, reps);
+        return 0;
+    }
+    if(inputs.empty())
+    {
+        inputs.push_back("pgn");
+    }
+
+    std::vector<std::filesystem::path> files;
+    for(const auto &p : inputs)
+    {
+        if(std::filesystem::is_directory(p))
+        {
+            for(const auto &entry : std::filesystem::directory_iterator(p))
+            {
+                if(entry.is_regular_file() && entry.path().extension() == ".5dpgn")
+                {
+                    files.push_back(entry.path());
+                }
+            }
+        }
+        else if(std::filesystem::exists(p))
+        {
+            files.push_back(p);
+        }
+        else
+        {
+            std::cerr << "No such file or directory: " << p << std::endl;
+            return 2;
+        }
+    }
+    // directory order is unspecified; sort to keep the output stable
+    std::sort(files.begin(), files.end());
+
+    std::vector<bench_result> results;
+    for(const auto &f : files)
+    {
+        results.push_back(run_bench(f, reps, max, depth, threads));
+    }
+    if(format == "json")
+    {
+        print_json(results, reps);
+    }
+    else
+    {
+        print_csv(results);
+    }
+    return 0;
+}
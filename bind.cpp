@@ -134,6 +134,27 @@ PYBIND11_MODULE(engine, m) {
             return "<action with " + std::to_string(a.get_moves().size()) + " moves>";
         })
     ;
+    py::class_<transposition_table, std::shared_ptr<transposition_table>> tt_class(m, "transposition_table");
+    py::enum_<transposition_table::policy>(tt_class, "policy")
+        .value("LRU", transposition_table::policy::LRU)
+        .value("FIFO", transposition_table::policy::FIFO);
+    tt_class
+        .def(py::init<size_t, transposition_table::policy, size_t>(),
+             py::arg("budget_bytes") = transposition_table::DEFAULT_BUDGET,
+             py::arg("policy") = transposition_table::policy::LRU,
+             py::arg("num_shards") = 16)
+        .def("clear", &transposition_table::clear)
+        .def("size", &transposition_table::size)
+        .def("memory_usage", &transposition_table::memory_usage)
+        .def("get_budget", &transposition_table::get_budget)
+        .def("get_hits", &transposition_table::get_hits)
+        .def("get_misses", &transposition_table::get_misses);
+    py::class_<board_interner, std::shared_ptr<board_interner>>(m, "board_interner")
+        .def(py::init<>())
+        .def("clear", &board_interner::clear)
+        .def("size", &board_interner::size)
+        .def("get_hits", &board_interner::get_hits)
+        .def("get_misses", &board_interner::get_misses);
     /*
     py::class_<state>(m, "state")
         .def_readwrite("m", &state::m)
@@ -144,7 +165,7 @@ PYBIND11_MODULE(engine, m) {
         // metadata
         .def_readwrite("metadata", &game::metadata)
         // factory
-        .def_static("from_pgn", &game::from_pgn)
+        .def_static("from_pgn", &game::from_pgn, py::arg("input"), py::arg("interner") = nullptr)
         // core functions
         .def("get_current_state", &game::get_current_state)
         .def("get_current_present", &game::get_current_present)
@@ -165,6 +186,10 @@ PYBIND11_MODULE(engine, m) {
         .def("get_current_checks", &game::get_current_checks)
         .def("get_board_size", &game::get_board_size)
         .def("suggest_action", &game::suggest_action)
+        .def("get_transposition_table", &game::get_transposition_table)
+        .def("set_transposition_table", &game::set_transposition_table)
+        .def("get_board_interner", &game::get_board_interner)
+        .def("set_board_interner", &game::set_board_interner)
         .def("get_comments", &game::get_comments)
         .def("has_parent", &game::has_parent)
         .def("visit_parent", &game::visit_parent)
@@ -3,9 +3,18 @@
 #include <regex>
 #include <chrono>
 #include <sstream>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <filesystem>
+#include <algorithm>
 
 #include "hypercuboid.h"
 #include "pgnparser.h"
+#include "pgn_reader.h"
+#include "searcher.h"
 
 //std::string pgn1 =
 //R"(
@@ -21,7 +30,7 @@
 template<bool C>
 generator<moveseq> naive_search_impl(state s, moveseq mvs, int k, bool b)
 {
-    if(s.find_checks(!C).first().has_value())
+    if(s.first_check(!C).has_value())
         co_return;
     if(s.can_submit())
         co_yield mvs;
@@ -188,6 +197,158 @@ void diff(state s)
     std::cout << std::endl;
 }
 
+/*
+ validate_batch(inputs, num_threads):
+ Replay every game of the given multi-game files (directories are scanned for *.5dpgn files,
+ `-` reads stdin) by constructing a state from it. Games are read on the main thread and
+ replayed by a pool of workers; results are printed in input order, followed by a summary.
+ Returns the exit code: 0 if every game is valid, 1 otherwise, 2 on bad input paths.
+ */
+int validate_batch(const std::vector<std::string> &inputs, int num_threads)
+{
+    if(num_threads <= 0)
+    {
+        num_threads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    }
+    std::vector<std::string> files;
+    for(const std::string &p : inputs)
+    {
+        if(p == "-")
+        {
+            files.push_back(p);
+        }
+        else if(std::filesystem::is_directory(p))
+        {
+            std::vector<std::string> found;
+            for(const auto &entry : std::filesystem::recursive_directory_iterator(p))
+            {
+                if(entry.is_regular_file() && entry.path().extension() == ".5dpgn")
+                {
+                    found.push_back(entry.path().string());
+                }
+            }
+            // directory order is unspecified; sort to keep the output stable
+            std::sort(found.begin(), found.end());
+            files.insert(files.end(), found.begin(), found.end());
+        }
+        else if(std::filesystem::exists(p))
+        {
+            files.push_back(p);
+        }
+        else
+        {
+            std::cerr << "No such file or directory: " << p << std::endl;
+            return 2;
+        }
+    }
+
+    struct job
+    {
+        size_t id;
+        std::string text;
+    };
+    struct outcome
+    {
+        std::string name; // <file>#<index in file>
+        std::string error; // empty iff the game is valid
+    };
+    std::vector<outcome> outcomes;
+    std::deque<job> queue;
+    bool done = false;
+    std::mutex mtx;
+    std::condition_variable not_empty, not_full;
+    const size_t max_queued = 4 * static_cast<size_t>(num_threads);
+
+    auto work = [&]() {
+        while(true)
+        {
+            job j;
+            {
+                std::unique_lock<std::mutex> lock(mtx);
+                not_empty.wait(lock, [&]{ return !queue.empty() || done; });
+                if(queue.empty())
+                    return;
+                j = std::move(queue.front());
+                queue.pop_front();
+            }
+            not_full.notify_one();
+            std::string error;
+            try {
+                pgnparser parser(j.text);
+                std::optional<pgnparser_ast::game> g = parser.parse_game();
+                if(!g || !parser.at_end())
+                    throw parse_error("parse failed");
+                state s(*g);
+            } catch (const parse_error &e) {
+                error = std::string("Parse Error: ") + e.what();
+            } catch (const std::exception &e) {
+                error = std::string("Runtime error: ") + e.what();
+            }
+            if(error.empty())
+                continue;
+            std::lock_guard<std::mutex> lock(mtx);
+            outcomes[j.id].error = std::move(error);
+        }
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for(int i = 0; i < num_threads; i++)
+    {
+        workers.emplace_back(work);
+    }
+    auto submit = [&](std::string name, std::string text) {
+        std::unique_lock<std::mutex> lock(mtx);
+        not_full.wait(lock, [&]{ return queue.size() < max_queued; });
+        outcomes.push_back(outcome{std::move(name), {}});
+        queue.push_back(job{outcomes.size() - 1, std::move(text)});
+        lock.unlock();
+        not_empty.notify_one();
+    };
+    for(const std::string &f : files)
+    {
+        try {
+            std::unique_ptr<pgn_reader> reader = f == "-" ? std::make_unique<pgn_reader>(std::cin)
+                                                          : std::make_unique<pgn_reader>(f);
+            while(std::optional<std::string_view> text = reader->next_text())
+            {
+                submit(f + "#" + std::to_string(reader->games_read()), std::string(*text));
+            }
+        } catch (const std::exception &e) {
+            std::lock_guard<std::mutex> lock(mtx);
+            outcomes.push_back(outcome{f, std::string("Runtime error: ") + e.what()});
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        done = true;
+    }
+    not_empty.notify_all();
+    for(std::thread &t : workers)
+    {
+        t.join();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    size_t failed = 0;
+    for(const outcome &o : outcomes)
+    {
+        if(o.error.empty())
+        {
+            std::cout << o.name << ": ok\n";
+        }
+        else
+        {
+            std::cout << o.name << ": " << o.error << "\n";
+            failed++;
+        }
+    }
+    std::cout << "Summary: " << outcomes.size() << " games, " << outcomes.size() - failed << " valid, "
+              << failed << " failed, " << num_threads << " threads, " << elapsed.count() << "s ("
+              << outcomes.size() / std::max(elapsed.count(), 1e-9) << " games/s)" << std::endl;
+    return failed ? 1 : 0;
+}
+
 std::string helpmsg = R"(usage: cli <option>
 where <option> is one of:
   help: print this message
@@ -196,9 +357,12 @@ where <option> is one of:
   all [fast|naive] [<max>]: display all legal moves capped by <max>
   checkmate [fast|naive]: determine whether the final state is checkmate/stalemate
   diff: compare the output of two algorithms
+  search [<depth>] [<ms>]: alpha-beta search up to <depth> (default 3) within <ms> milliseconds (default unlimited)
+  validate-batch [--threads <n>] <path>...: replay every game in the given multi-game files and
+      directories (scanned for *.5dpgn files, `-` is stdin) on <n> threads (default: all hardware threads)
 default value for <max> is 10000
 
-the game being read is input in stdin (stopped by EOF)
+except for validate-batch, the game being read is input in stdin (stopped by EOF)
 )";
 
 int main(int argc, const char *argv[])
@@ -210,6 +374,25 @@ int main(int argc, const char *argv[])
     
     std::string command = argv[1];
     
+    if (command == "validate-batch")
+    {
+        int threads = 0;
+        std::vector<std::string> inputs;
+        for (int i = 2; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--threads" && i + 1 < argc) {
+                threads = std::stoi(argv[++i]);
+            } else {
+                inputs.push_back(arg);
+            }
+        }
+        if (inputs.empty()) {
+            std::cerr << "validate-batch: no input given" << std::endl;
+            return 2;
+        }
+        return validate_batch(inputs, threads);
+    }
+    
     std::ostringstream buffer;
     buffer << std::cin.rdbuf();
     std::string pgn = buffer.str();
@@ -315,7 +498,7 @@ int main(int argc, const char *argv[])
         }
         else
         {
-            if(ps->phantom().find_checks(!c).first())
+            if(ps->phantom().first_check(!c))
             {
                 std::cout << "Checkmate";
             }
@@ -330,6 +513,28 @@ int main(int argc, const char *argv[])
     {
         diff(*ps);
     }
+    else if (command == "search")
+    {
+        searcher::limits lim;
+        if(argc > 2)
+            lim.max_depth = std::stoi(argv[2]);
+        if(argc > 3)
+            lim.time = std::chrono::milliseconds(std::stoi(argv[3]));
+        searcher sr;
+        auto start = std::chrono::high_resolution_clock::now();
+        searcher::result res = sr.search(*ps, lim);
+        auto end = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double> elapsed = end - start;
+        std::cout << "depth " << res.depth << " score " << res.score << " nodes " << res.nodes
+                  << " time " << elapsed.count() << "s\npv:";
+        state t = *ps;
+        for(const action &act : res.pv)
+        {
+            std::cout << " " << t.pretty_action(act);
+            t = *t.can_apply(act);
+        }
+        std::cout << std::endl;
+    }
     else
     {
         std::cerr << "Unknown command: " << command << std::endl;
@@ -0,0 +1,89 @@
+#ifndef BITBOARD4_H
+#define BITBOARD4_H
+
+#include <array>
+#include "bitboard.h"
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+/*
+ bitboard4: four bitboards operated in lockstep, one per lane.
+ When the compiler targets AVX2 (cmake -DAVX2=ON), a bitboard4 lives in a 256-bit register and
+ every operation is a single instruction; otherwise the operations loop over the lanes.
+ */
+struct bitboard4
+{
+    using lanes_t = std::array<bitboard_t, 4>;
+#ifdef __AVX2__
+    __m256i v;
+
+    static bitboard4 broadcast(bitboard_t b)
+    {
+        return {_mm256_set1_epi64x(static_cast<long long>(b))};
+    }
+    static bitboard4 load(const lanes_t &a)
+    {
+        return {_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a.data()))};
+    }
+    lanes_t store() const
+    {
+        lanes_t a;
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(a.data()), v);
+        return a;
+    }
+    bitboard4 operator&(bitboard4 other) const
+    {
+        return {_mm256_and_si256(v, other.v)};
+    }
+    bitboard4 operator|(bitboard4 other) const
+    {
+        return {_mm256_or_si256(v, other.v)};
+    }
+    // this & ~other
+    bitboard4 andnot(bitboard4 other) const
+    {
+        return {_mm256_andnot_si256(other.v, v)};
+    }
+    bool none() const
+    {
+        return _mm256_testz_si256(v, v);
+    }
+#else
+    lanes_t v;
+
+    static bitboard4 broadcast(bitboard_t b)
+    {
+        return {{b, b, b, b}};
+    }
+    static bitboard4 load(const lanes_t &a)
+    {
+        return {a};
+    }
+    lanes_t store() const
+    {
+        return v;
+    }
+    bitboard4 operator&(bitboard4 other) const
+    {
+        return {{v[0] & other.v[0], v[1] & other.v[1], v[2] & other.v[2], v[3] & other.v[3]}};
+    }
+    bitboard4 operator|(bitboard4 other) const
+    {
+        return {{v[0] | other.v[0], v[1] | other.v[1], v[2] | other.v[2], v[3] | other.v[3]}};
+    }
+    bitboard4 andnot(bitboard4 other) const
+    {
+        return {{v[0] & ~other.v[0], v[1] & ~other.v[1], v[2] & ~other.v[2], v[3] & ~other.v[3]}};
+    }
+    bool none() const
+    {
+        return (v[0] | v[1] | v[2] | v[3]) == 0;
+    }
+#endif
+    bitboard4 &operator&=(bitboard4 other) { return *this = *this & other; }
+    bitboard4 &operator|=(bitboard4 other) { return *this = *this | other; }
+};
+
+#endif /* BITBOARD4_H */
@@ -5,8 +5,14 @@
 #include <sstream>
 
 #include "magic.h"
+#include "board_interner.h"
 
-board::board(std::string fen, int size_x, int size_y) : bbs{}, umove_mask{0}
+const std::array<uint64_t, (board::BBS_INDICES_COUNT+1)*BOARD_SIZE> board::zobrist_keys = generate_array(std::make_index_sequence<(BBS_INDICES_COUNT+1)*BOARD_SIZE>{}, [](size_t i) -> uint64_t
+{
+    return splitmix64(i);
+});
+
+board::board(std::string fen, int size_x, int size_y) : bbs{}, umove_mask{0}, zhash{0}
 {
     array_board arrb(fen, size_x, size_y);
     for(int i = 0; i < BOARD_SIZE; i++)
@@ -17,84 +23,104 @@ board::board(std::string fen, int size_x, int size_y) : bbs{}, umove_mask{0}
         if(piece_umove_flag(p0))
         {
             umove_mask |= pmask(i);
+            zhash ^= zobrist_keys[BBS_INDICES_COUNT*BOARD_SIZE + i];
         }
     }
 }
 
-piece_t board::get_piece(int pos) const
+board::board(const raw_t &raw) : bbs{}, umove_mask{raw[BBS_INDICES_COUNT]}, zhash{0}
 {
-    piece_t piece;
-    bitboard_t z = pmask(pos);
-    if(z & bbs[WHITE])
+    std::copy(raw.begin(), raw.begin() + BBS_INDICES_COUNT, bbs.begin());
+    for(int i = 0; i <= BBS_INDICES_COUNT; i++)
     {
-        if(z & king())
-            piece = KING_W;
-        else if(z & common_king())
-            piece = COMMON_KING_W;
-        else if(z & queen())
-            piece = QUEEN_W;
-        else if(z & royal_queen())
-            piece = ROYAL_QUEEN_W;
-        else if(z & bishop())
-            piece = BISHOP_W;
-        else if(z & knight())
-            piece = KNIGHT_W;
-        else if(z & rook())
-            piece = ROOK_W;
-        else if(z & pawn())
-            piece = PAWN_W;
-        else if(z & unicorn())
-            piece = UNICORN_W;
-        else if(z & dragon())
-            piece = DRAGON_W;
-        else if(z & brawn())
-            piece = BRAWN_W;
-        else if(z & princess())
-            piece = PRINCESS_W;
-        else if(z & wall())
-            piece = WALL_PIECE;
-        else
-            throw std::runtime_error("get_piece: unknown piece\n");
+        for(bitboard_t b = raw[i]; b; b &= b - 1)
+        {
+            zhash ^= zobrist_keys[i*BOARD_SIZE + std::countr_zero(b)];
+        }
     }
-    else if(z & bbs[BLACK])
+}
+
+board::raw_t board::to_raw() const
+{
+    raw_t raw;
+    std::copy(bbs.begin(), bbs.end(), raw.begin());
+    raw[BBS_INDICES_COUNT] = umove_mask;
+    return raw;
+}
+
+const std::array<piece_t, 1 << board::BBS_INDICES_COUNT> board::piece_table = generate_array(std::make_index_sequence<1 << BBS_INDICES_COUNT>{}, [](size_t bits) -> piece_t
+{
+    auto has = [bits](int i) {
+        return bool(bits & (size_t(1) << i));
+    };
+    bool white = has(WHITE), black = has(BLACK), royal = has(ROYAL);
+    bool lrook = has(LROOK), lbishop = has(LBISHOP), lunicorn = has(LUNICORN), ldragon = has(LDRAGON);
+    piece_t piece;
+    // same precedence as the definitions of king(), common_king(), ... in board.h
+    if(!white && !black)
+        return NO_PIECE;
+    else if(has(LKING) && royal)
+        piece = KING_W;
+    else if(has(LKING))
+        piece = COMMON_KING_W;
+    else if(lrook && ldragon && !royal)
+        piece = QUEEN_W;
+    else if(lrook && ldragon)
+        piece = ROYAL_QUEEN_W;
+    else if(lbishop && !lrook)
+        piece = BISHOP_W;
+    else if(has(LKNIGHT))
+        piece = KNIGHT_W;
+    else if(lrook && !lbishop)
+        piece = ROOK_W;
+    else if(has(LPAWN) && !has(LRAWN))
+        piece = PAWN_W;
+    else if(lunicorn && !ldragon)
+        piece = UNICORN_W;
+    else if(ldragon && !lunicorn)
+        piece = DRAGON_W;
+    else if(has(LPAWN) && has(LRAWN))
+        piece = BRAWN_W;
+    else if(lrook && lbishop && !lunicorn)
+        piece = PRINCESS_W;
+    else if(white && black)
+        return WALL_PIECE;
+    else
+        return UNKNOWN_PIECE;
+    return white ? piece : to_black(piece);
+});
+
+void board::throw_unknown_piece()
+{
+    throw std::runtime_error("board::get_piece: unknown piece\n");
+}
+
+uint64_t board::square_hash(int pos) const
+{
+    uint64_t h = 0;
+    for(int i = 0; i < BBS_INDICES_COUNT; i++)
     {
-        if(z & king())
-            piece = KING_B;
-        else if(z & common_king())
-            piece = COMMON_KING_B;
-        else if(z & queen())
-            piece = QUEEN_B;
-        else if(z & royal_queen())
-            piece = ROYAL_QUEEN_B;
-        else if(z & bishop())
-            piece = BISHOP_B;
-        else if(z & knight())
-            piece = KNIGHT_B;
-        else if(z & rook())
-            piece = ROOK_B;
-        else if(z & pawn())
-            piece = PAWN_B;
-        else if(z & unicorn())
-            piece = UNICORN_B;
-        else if(z & dragon())
-            piece = DRAGON_B;
-        else if(z & brawn())
-            piece = BRAWN_B;
-        else if(z & princess())
-            piece = PRINCESS_B;
-        else
-            throw std::runtime_error("board::get_piece: unknown piece\n");
+        if((bbs[i] >> pos) & 1)
+        {
+            h ^= zobrist_keys[i*BOARD_SIZE + pos];
+        }
     }
-    else
+    if((umove_mask >> pos) & 1)
     {
-        piece = NO_PIECE;
+        h ^= zobrist_keys[BBS_INDICES_COUNT*BOARD_SIZE + pos];
     }
-    return piece;
+    return h;
+}
+
+bool board::operator==(const board& other) const
+{
+    return zhash == other.zhash && bbs == other.bbs && umove_mask == other.umove_mask;
 }
 
 void board::set_piece(int pos, piece_t p)
 {
     bitboard_t z = pmask(pos);
+    zhash ^= square_hash(pos);
     umove_mask &= ~z;
     for(int i = 0; i < BBS_INDICES_COUNT; i++)
     {
@@ -168,21 +194,32 @@ void board::set_piece(int pos, piece_t p)
                 break;
         }
     }
+    zhash ^= square_hash(pos);
 }
 
 std::shared_ptr<board> board::replace_piece(int pos, piece_t p) const
 {
-    std::shared_ptr<board> b_ptr = std::make_shared<board>(*this);
+    std::shared_ptr<board> b_ptr = make_board(*this);
     b_ptr->set_piece(pos, p);
-    return b_ptr;
+    return board_interner::canonical(b_ptr);
 }
 
 std::shared_ptr<board> board::move_piece(int from, int to) const
 {
-    std::shared_ptr<board> b_ptr = std::make_shared<board>(*this);
+    std::shared_ptr<board> b_ptr = make_board(*this);
     b_ptr->set_piece(to, get_piece(from));
     b_ptr->set_piece(from, NO_PIECE);
-    return b_ptr;
+    return board_interner::canonical(b_ptr);
+}
+
+std::shared_ptr<board> board::replace_pieces(std::initializer_list<std::pair<int, piece_t>> changes) const
+{
+    std::shared_ptr<board> b_ptr = make_board(*this);
+    for(const auto &[pos, p] : changes)
+    {
+        b_ptr->set_piece(pos, p);
+    }
+    return board_interner::canonical(b_ptr);
 }
 
 array_board board::to_array_board() const
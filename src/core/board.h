@@ -11,8 +11,12 @@
 #include <iostream>
 #include <array>
 #include <string>
+#include <memory>
+#include <utility>
+#include <initializer_list>
 #include "piece.h"
 #include "bitboard.h"
+#include "pool_allocator.h"
 
 class array_board;
 
@@ -29,11 +33,35 @@ class board
     };
     std::array<bitboard_t, BBS_INDICES_COUNT> bbs;
     bitboard_t umove_mask;
+    /*
+     Zobrist hash: xor of zobrist_keys[i*BOARD_SIZE+pos] over all bits `pos` set in bbs[i],
+     where i=BBS_INDICES_COUNT stands for umove_mask. It is kept up to date by set_piece().
+     */
+    uint64_t zhash;
+    static const std::array<uint64_t, (BBS_INDICES_COUNT+1)*BOARD_SIZE> zobrist_keys;
+    uint64_t square_hash(int pos) const;
+    /*
+     piece_table[bits]: the piece on a square whose membership in bbs[i] is bit i of `bits`,
+     or UNKNOWN_PIECE if no piece has this combination. It is the lookup table of get_piece().
+     */
+    constexpr static piece_t UNKNOWN_PIECE = static_cast<piece_t>(0xff);
+    static const std::array<piece_t, 1 << BBS_INDICES_COUNT> piece_table;
+    [[noreturn]] static void throw_unknown_piece();
 
 public:
+    /*
+     raw_t: the bitboards followed by umove_mask, i.e. everything except the hash.
+     It is the layout of boards in the binary format of multiverse::serialize().
+     */
+    constexpr static size_t RAW_SIZE = BBS_INDICES_COUNT + 1;
+    using raw_t = std::array<bitboard_t, RAW_SIZE>;
+
     board(std::string fen, int size_x = BOARD_LENGTH, int size_y = BOARD_LENGTH);
+    explicit board(const raw_t &raw);
+    raw_t to_raw() const;
     // inline getter functions
     constexpr bitboard_t umove() const { return umove_mask; }
+    constexpr uint64_t hash() const { return zhash; }
 
     constexpr bitboard_t white() const { return bbs[WHITE]; }
     constexpr bitboard_t black() const { return bbs[BLACK]; }
@@ -96,16 +124,39 @@ public:
         }
     }
     
+    // a table lookup on the bits of `pos` in all bitboards
+    piece_t get_piece(int pos) const
+    {
+        size_t bits = 0;
+        for(int i = 0; i < BBS_INDICES_COUNT; i++)
+        {
+            bits |= size_t((bbs[i] >> pos) & 1) << i;
+        }
+        piece_t piece = piece_table[bits];
+        if(piece == UNKNOWN_PIECE) [[unlikely]]
+        {
+            throw_unknown_piece();
+        }
+        return piece;
+    }
+
     // modifications
-    piece_t get_piece(int pos) const;
     void set_piece(int pos, piece_t p);
     std::shared_ptr<board> replace_piece(int pos, piece_t p) const;
     std::shared_ptr<board> move_piece(int from, int to) const;
+    /*
+     replace_pieces({{pos0, p0}, {pos1, p1}, ...}): a new board with these pieces set in order.
+     Equivalent to chained replace_piece() calls but only one board is allocated.
+     */
+    std::shared_ptr<board> replace_pieces(std::initializer_list<std::pair<int, piece_t>> changes) const;
     array_board to_array_board() const;
     std::string to_string() const;
     
     template<bool SHOW_UMOVE=false>
     std::string get_fen() const;
+    
+    // two boards are equal iff they have the same pieces and umove flags
+    bool operator==(const board& other) const;
 
     // all the pieces (both white and black) that attacks a given square
     bitboard_t attacks_to(int pos) const;
@@ -113,6 +164,15 @@ public:
     bool is_under_attack(int pos, int color) const;
 };
 
+/*
+ make_board(args...): construct a board in a block from the board pool,
+ which is cheaper than std::make_shared<board> (see pool_allocator.h)
+ */
+template<typename ...Args>
+std::shared_ptr<board> make_board(Args&&... args)
+{
+    return std::allocate_shared<board>(pool_allocator<board>{}, std::forward<Args>(args)...);
+}
 
 class array_board {
 private:
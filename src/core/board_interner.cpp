@@ -0,0 +1,94 @@
+#include "board_interner.h"
+#include <algorithm>
+
+constexpr static size_t MIN_SWEEP_THRESHOLD = 1024;
+
+board_interner::board_interner() : table{}, sweep_threshold(MIN_SWEEP_THRESHOLD), hits(0), misses(0) {}
+
+void board_interner::sweep()
+{
+    std::erase_if(table, [](const auto &kv) {
+        return kv.second.expired();
+    });
+    sweep_threshold = std::max(MIN_SWEEP_THRESHOLD, 2 * table.size());
+}
+
+std::shared_ptr<board> board_interner::intern(const std::shared_ptr<board> &b_ptr)
+{
+    uint64_t key = b_ptr->hash();
+    std::lock_guard<std::mutex> lock(mtx);
+    auto [first, last] = table.equal_range(key);
+    for(auto it = first; it != last; ++it)
+    {
+        std::shared_ptr<board> existing = it->second.lock();
+        if(existing == b_ptr)
+        {
+            return existing;
+        }
+        if(existing && *existing == *b_ptr)
+        {
+            hits++;
+            return existing;
+        }
+    }
+    misses++;
+    // reuse an expired slot of the same hash before adding a new one
+    for(auto it = first; it != last; ++it)
+    {
+        if(it->second.expired())
+        {
+            it->second = b_ptr;
+            return b_ptr;
+        }
+    }
+    table.emplace(key, b_ptr);
+    if(table.size() >= sweep_threshold)
+    {
+        sweep();
+    }
+    return b_ptr;
+}
+
+void board_interner::clear()
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    table.clear();
+    sweep_threshold = MIN_SWEEP_THRESHOLD;
+    hits = 0;
+    misses = 0;
+}
+
+size_t board_interner::size() const
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    return table.size();
+}
+
+size_t board_interner::get_hits() const
+{
+    return hits;
+}
+
+size_t board_interner::get_misses() const
+{
+    return misses;
+}
+
+std::shared_ptr<board> board_interner::canonical(const std::shared_ptr<board> &b_ptr)
+{
+    if(active)
+    {
+        return active->intern(b_ptr);
+    }
+    return b_ptr;
+}
+
+board_interner::scope::scope(board_interner *bi) : prev(active)
+{
+    active = bi;
+}
+
+board_interner::scope::~scope()
+{
+    active = prev;
+}
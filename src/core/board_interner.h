@@ -0,0 +1,64 @@
+// board_interner.h
+// hash-consing of boards, so that identical boards share one allocation
+
+#ifndef BOARD_INTERNER_H
+#define BOARD_INTERNER_H
+
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include "board.h"
+
+/*
+ A thread-safe intern table of boards keyed by board::hash().
+
+ intern(b) returns a previously interned board equal to `b` if it is still alive, otherwise it
+ records `b` and returns it. The table only holds weak references, so it never keeps a board
+ alive; expired entries are swept whenever the table has doubled in size since the last sweep.
+
+ Board edits (board::replace_piece, move_piece, replace_pieces) and multiverse construction
+ canonicalize their results through the interner installed on the current thread by a `scope`
+ object. Without one, boards are not interned.
+ */
+class board_interner
+{
+    mutable std::mutex mtx;
+    std::unordered_multimap<uint64_t, std::weak_ptr<board>> table;
+    size_t sweep_threshold;
+    std::atomic<size_t> hits, misses;
+
+    inline static thread_local board_interner *active = nullptr;
+
+    void sweep();
+
+public:
+    board_interner();
+
+    std::shared_ptr<board> intern(const std::shared_ptr<board> &b_ptr);
+    void clear();
+    size_t size() const; // number of entries, including expired ones not swept yet
+    size_t get_hits() const;
+    size_t get_misses() const;
+
+    /*
+     canonical(b): intern `b` with the interner active on this thread, or return it unchanged if there is none
+     */
+    static std::shared_ptr<board> canonical(const std::shared_ptr<board> &b_ptr);
+
+    /*
+     RAII guard making an interner (possibly null, i.e. disabled) active on the current thread.
+     The previously active interner is restored on destruction.
+     */
+    class scope
+    {
+        board_interner *prev;
+    public:
+        explicit scope(board_interner *bi);
+        ~scope();
+        scope(const scope&) = delete;
+        scope &operator=(const scope&) = delete;
+    };
+};
+
+#endif /* BOARD_INTERNER_H */
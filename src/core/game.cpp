@@ -23,21 +23,28 @@ std::string show_comments(std::vector<std::string> const& comments)
 }
 
 game::game(std::unique_ptr<gnode<comments_t>> gt)
-: gametree{std::move(gt)}, current_node{gametree.get()}, cached{}
+: gametree{std::move(gt)}, current_node{gametree.get()}, cached{}, tt{std::make_shared<transposition_table>()}, interner{}
 {
     cached.push_back(std::make_pair(current_node->get_state(), std::nullopt));
     now = cached.begin();
 }
 
-game game::from_pgn(std::string input)
+game game::from_pgn(std::string input, std::shared_ptr<board_interner> interner)
 {
     auto ag = pgnparser(input).parse_game();
     if(!ag.has_value())
         throw std::runtime_error("Bad input, parse failed");
-    pgnparser_ast::gametree gt_ast = std::move(ag->gt);
-    ag->gt = {};
-    game g(gnode<comments_t>::create_root(state(*ag), comments_t{}));
-    g.metadata = ag->headers;
+    return from_ast(std::move(*ag), interner);
+}
+
+game game::from_ast(pgnparser_ast::game ag, std::shared_ptr<board_interner> interner)
+{
+    board_interner::scope guard(interner.get());
+    pgnparser_ast::gametree gt_ast = std::move(ag.gt);
+    ag.gt = {};
+    game g(gnode<comments_t>::create_root(state(ag), comments_t{}));
+    g.metadata = std::move(ag.headers);
+    g.interner = interner;
     gnode<comments_t> *cn = nullptr;
     // parse moves
     std::function<void(gnode<comments_t>*, const pgnparser_ast::gametree&)> dfs;
@@ -157,20 +164,11 @@ std::vector<vec4> game::gen_move_if_playable(vec4 p)
 match_status_t game::get_match_status() const
 {
     const state &s = current_node->get_state();
-    auto [w, ss] = HC_info::build_HC(s);
-    if(w.search(ss).first().has_value())
-    {
-        return match_status_t::PLAYING;
-    }
-    auto [t, c] = s.get_present();
-    if(s.phantom().find_checks(!c).first().has_value())
-    {
-        return c ? match_status_t::WHITE_WINS : match_status_t::BLACK_WINS;
-    }
-    else
+    if(tt)
     {
-        return match_status_t::STALEMATE;
+        return tt->query(s).status;
     }
+    return transposition_table::compute(s).status;
 }
 
 std::vector<vec4> game::get_movable_pieces() const
@@ -238,6 +236,7 @@ bool game::redo()
 
 bool game::apply_move(ext_move m)
 {
+    board_interner::scope guard(interner.get());
     std::optional<state> ans = now->first.can_apply(m.fm, m.promote_to);
     if(ans)
     {
@@ -252,6 +251,7 @@ bool game::apply_move(ext_move m)
 
 bool game::submit()
 {
+    board_interner::scope guard(interner.get());
     std::optional<state> ans = now->first.can_submit();
     if(ans)
     {
@@ -272,7 +272,7 @@ bool game::submit()
 bool game::currently_check() const
 {
     auto [t, c] = get_current_state().get_present();
-    return get_current_state().find_checks(!c).first().has_value();
+    return get_current_state().first_check(!c).has_value();
 }
 
 std::vector<std::pair<vec4, vec4>> game::get_current_checks() const
@@ -293,7 +293,37 @@ std::pair<int, int> game::get_board_size() const
 
 bool game::suggest_action()
 {
+    board_interner::scope guard(interner.get());
     const state &s = current_node->get_state();
+    if(tt)
+    {
+        // try the cached actions before falling back to a fresh search
+        transposition_table::entry e = tt->query(s);
+        if(!e.first_action)
+        {
+            return false;
+        }
+        std::vector<action> candidates = e.actions.value_or(std::vector<action>{*e.first_action});
+        bool all_valid = true;
+        for(const action &act : candidates)
+        {
+            if(!s.can_apply(act))
+            {
+                all_valid = false;
+                continue;
+            }
+            if(!current_node->find_child(act))
+            {
+                visit_child(act);
+                visit_parent();
+                return true;
+            }
+        }
+        if(e.actions && all_valid)
+        {
+            return false;
+        }
+    }
     auto [w, ss] = HC_info::build_HC(s);
     for(moveseq mvs : w.search(ss))
     {
@@ -312,6 +342,26 @@ bool game::suggest_action()
     return false;
 }
 
+std::shared_ptr<transposition_table> game::get_transposition_table() const
+{
+    return tt;
+}
+
+void game::set_transposition_table(std::shared_ptr<transposition_table> table)
+{
+    tt = std::move(table);
+}
+
+std::shared_ptr<board_interner> game::get_board_interner() const
+{
+    return interner;
+}
+
+void game::set_board_interner(std::shared_ptr<board_interner> bi)
+{
+    interner = std::move(bi);
+}
+
 /////////////////////////////
 // Comments and navigation //
 /////////////////////////////
@@ -328,6 +378,7 @@ bool game::has_parent() const
 
 void game::visit_parent()
 {
+    board_interner::scope guard(interner.get());
     if(!has_parent())
         return;
     current_node = current_node->get_parent();
@@ -350,6 +401,7 @@ std::vector<std::tuple<action, std::string>> game::get_child_moves() const
 
 bool game::visit_child(action act, comments_t comments, std::optional<state> newstate)
 {
+    board_interner::scope guard(interner.get());
     // check if the child already exists
     auto &children = current_node->get_children();
     for(auto &child : children)
@@ -10,6 +10,8 @@
 #include <set>
 #include "state.h"
 #include "gametree.h"
+#include "transposition_table.h"
+#include "board_interner.h"
 
 class game
 {
@@ -19,13 +21,19 @@ class game
     using cache_t = std::pair<state,std::optional<ext_move>>;
     std::vector<cache_t> cached;
     std::vector<cache_t>::iterator now;
+    // shared cache of search results, may be null (i.e. disabled)
+    std::shared_ptr<transposition_table> tt;
+    // boards created by this game are interned here, may be null (i.e. disabled)
+    std::shared_ptr<board_interner> interner;
     
     game(std::unique_ptr<gnode<comments_t>> gt);
     void fresh();
 public:
     std::map<std::string, std::string> metadata;
     
-    static game from_pgn(std::string str);
+    static game from_pgn(std::string str, std::shared_ptr<board_interner> interner = nullptr);
+    // build a game from an already parsed game, e.g. one read by pgn_reader
+    static game from_ast(pgnparser_ast::game ag, std::shared_ptr<board_interner> interner = nullptr);
     
     const state &get_current_state() const;
     std::pair<int, bool> get_current_present() const;
@@ -49,6 +57,11 @@ public:
     std::pair<int, int> get_board_size() const;
     
     bool suggest_action();
+    
+    std::shared_ptr<transposition_table> get_transposition_table() const;
+    void set_transposition_table(std::shared_ptr<transposition_table> table);
+    std::shared_ptr<board_interner> get_board_interner() const;
+    void set_board_interner(std::shared_ptr<board_interner> bi);
 
     comments_t get_comments() const;
     //TODO: implement comment editing functions
@@ -1,6 +1,13 @@
 
 #include "hypercuboid.h"
 #include "graph.h"
+#include <algorithm>
+#include <limits>
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <exception>
 
 
 // for debug
@@ -60,7 +67,7 @@ std::pair<int, int> extract_tl(const semimove& loc)
 std::tuple<std::vector<vec4>, int> get_move_path(const state &s, full_move fm, int c)
 {
     const vec4 p = fm.from, q = fm.to, d = q - p;
-    std::shared_ptr<board> b_ptr = s.get_board(p.l(), p.t(), c);
+    const board *b_ptr = s.get_board_ptr(p.l(), p.t(), c);
     if(b_ptr->sliding() & pmask(p.xy()))
     {
         // this piece is sliding, makes sense to talk about path
@@ -130,8 +137,7 @@ std::tuple<HC_info, search_space> HC_info::build_HC(const state& s)
     for(vec4 from : s.gen_movable_pieces())
     {
         bool has_depart = false;
-        for(const vec4 &to : s.gen_piece_move(from))
-        {
+        s.visit_piece_move(from, [&](vec4 to) {
             full_move m(from, to);
             if(from.tl() != to.tl())
             {
@@ -146,8 +152,8 @@ std::tuple<HC_info, search_space> HC_info::build_HC(const state& s)
             {
                 stays_on[from.l()].push_back(m);
             }
-        }
-        
+            return false;
+        });
     }
     
     size_t estimate_size = 1 + arrives_to.size() + departs_from.size();
@@ -161,23 +167,28 @@ std::tuple<HC_info, search_space> HC_info::build_HC(const state& s)
         {
             vec4 p = m.from, q = m.to;
             vec4 d = q - p;
-            const std::shared_ptr<board>& b_ptr = s.get_board(p.l(), p.t(), player);
+            const board *b_ptr = s.get_board_ptr(p.l(), p.t(), player);
             std::shared_ptr<board> newboard = nullptr;
             bitboard_t z = pmask(p.xy());
             // en passant
             if((b_ptr->lpawn()&z) && d.x()!=0 && b_ptr->get_piece(q.xy()) == NO_PIECE)
             {
                 dprint(" ... en passant");
-                newboard = b_ptr->replace_piece(ppos(q.x(),p.y()), NO_PIECE)
-                                ->move_piece(p.xy(), q.xy());
+                newboard = b_ptr->replace_pieces({
+                    {ppos(q.x(),p.y()), NO_PIECE},
+                    {q.xy(), b_ptr->get_piece(p.xy())},
+                    {p.xy(), NO_PIECE}
+                });
             }
             // promotion
             else if((b_ptr->lpawn()&z) && (q.y() == 0 || q.y() == size_y - 1))
             {
                 dprint(" ... promotion");
                 piece_t promoted = player ? to_black(promote_to) : promote_to;
-                newboard = b_ptr->replace_piece(p.xy(), NO_PIECE)
-                                ->replace_piece(q.xy(), promoted);
+                newboard = b_ptr->replace_pieces({
+                    {p.xy(), NO_PIECE},
+                    {q.xy(), promoted}
+                });
             }
             // castling
             else if((b_ptr->king()&z) && abs(d.x()) > 1)
@@ -185,8 +196,12 @@ std::tuple<HC_info, search_space> HC_info::build_HC(const state& s)
                 dprint(" ... castling");
                 int rook_x1 = d.x() < 0 ? 0 : (size_x - 1); //rook's original x coordinate
                 int rook_x2 = q.x() + (d.x() < 0 ? 1 : -1); //rook's new x coordinate
-                newboard = b_ptr->move_piece(ppos(rook_x1, p.y()), ppos(rook_x2,q.y()))
-                                ->move_piece(p.xy(), q.xy());
+                newboard = b_ptr->replace_pieces({
+                    {ppos(rook_x2, q.y()), b_ptr->get_piece(ppos(rook_x1, p.y()))},
+                    {ppos(rook_x1, p.y()), NO_PIECE},
+                    {q.xy(), b_ptr->get_piece(p.xy())},
+                    {p.xy(), NO_PIECE}
+                });
             }
             // normal move
             else
@@ -206,7 +221,7 @@ std::tuple<HC_info, search_space> HC_info::build_HC(const state& s)
         {
             assert(!jump_indices.contains(p));
             // store the departing board after move is made
-            std::shared_ptr<board> b_ptr = s.get_board(p.l(), p.t(), player)
+            std::shared_ptr<board> b_ptr = s.get_board_ptr(p.l(), p.t(), player)
                 ->replace_piece(p.xy(), NO_PIECE);
             dprint(locs.size(), "depart", p);
             bool flag = has_physical_check(*b_ptr, player);
@@ -226,7 +241,7 @@ std::tuple<HC_info, search_space> HC_info::build_HC(const state& s)
                 // store the arriving board after move is made
                 vec4 p = m.from, q = m.to;
                 piece_t pic = s.get_piece(p, player);
-                const std::shared_ptr<board>& c_ptr = s.get_board(q.l(), q.t(), player);
+                const board *c_ptr = s.get_board_ptr(q.l(), q.t(), player);
                 
                 dprint(" ... nonbranching jump");
                 std::shared_ptr<board> newboard = c_ptr->replace_piece(q.xy(), pic);
@@ -268,7 +283,7 @@ std::tuple<HC_info, search_space> HC_info::build_HC(const state& s)
         {
             vec4 p = m.from, q = m.to;
             piece_t pic = s.get_piece(p, player);
-            const std::shared_ptr<board>& c_ptr = s.get_board(q.l(), q.t(), player);
+            const board *c_ptr = s.get_board_ptr(q.l(), q.t(), player);
             
             dprint(" ... branching jump");
             std::shared_ptr<board> newboard = c_ptr->replace_piece(q.xy(), pic);
@@ -343,7 +358,12 @@ std::tuple<HC_info, search_space> HC_info::build_HC(const state& s)
     }
 #endif
     
-    HC_info info(s, line_to_axis, axis_coords, universe, new_axis, dimension, mandatory_timelines);
+    // boards on unplayable lines are the same after every action
+    bool physical_checks_filtered = std::none_of(unplayable_timelines.begin(), unplayable_timelines.end(), [&s, player](int l) {
+        auto [t, c] = s.get_timeline_end(l);
+        return has_physical_check(*s.get_board_ptr(l, t, c), player);
+    });
+    HC_info info(s, line_to_axis, axis_coords, universe, new_axis, dimension, mandatory_timelines, physical_checks_filtered);
     
     
     // split the search space by number of branches
@@ -369,7 +389,7 @@ std::tuple<HC_info, search_space> HC_info::build_HC(const state& s)
 }
 
 
-std::optional<point> HC_info::take_point(HC &hc) const
+std::optional<point> HC_info::take_point(HC &hc, const axis_scores_t *scores) const
 {
     dprint("take_point()");
     graph g(dimension);
@@ -388,7 +408,7 @@ std::optional<point> HC_info::take_point(HC &hc) const
             const semimove& loc = axis_coords[n][i];
             std::visit(overloads {
                 [&](const physical_move&) {
-                    if(!has_nonjump)
+                    if(!has_nonjump || (scores && (*scores)[n][i] > (*scores)[n][result[n]]))
                     {
                         has_nonjump = true;
                         result[n] = i;
@@ -412,10 +432,21 @@ std::optional<point> HC_info::take_point(HC &hc) const
                         edge_refs[std::make_pair(n, from_axis)] = i;
                         assert(loc.idx != -1);
                     }
+                    else if(scores)
+                    {
+                        // keep the pair of departing/arriving moves with the highest score
+                        int &dep = edge_refs[std::make_pair(from_axis, n)];
+                        int &arr = edge_refs[std::make_pair(n, from_axis)];
+                        if((*scores)[from_axis][loc.idx] + (*scores)[n][i] > (*scores)[from_axis][dep] + (*scores)[n][arr])
+                        {
+                            dep = loc.idx;
+                            arr = i;
+                        }
+                    }
                 },
                 [](const departing_move&) {},
                 [&](const null_move&) {
-                    if(!has_nonjump)
+                    if(!has_nonjump || (scores && (*scores)[n][i] > (*scores)[n][result[n]]))
                     {
                         has_nonjump = true;
                         result[n] = i;
@@ -781,8 +812,10 @@ std::optional<slice> HC_info::find_checks(const point &p, const HC& hc) const
     //dprint("after applying moves:", mvsstr, newstate.to_string());
     dprint("applied moves:", mvsstr);
     dprint("c=", c);
-    auto gen = newstate.find_checks(!c);
-    if(auto maybe_check = gen.first())
+    // physical checks on the new boards were excluded when the semimoves were generated
+    auto maybe_check = physical_checks_filtered ? newstate.first_superphysical_check(!c) : newstate.first_check(!c);
+    assert(maybe_check.has_value() == newstate.first_check(!c).has_value());
+    if(maybe_check)
     {
         // there is a check
         // the slice to remove is a product of coordinates on certain axes
@@ -1059,6 +1092,193 @@ generator<moveseq> HC_info::search(search_space ss) const
     co_return;
 }
 
+generator<moveseq> HC_info::search(search_space ss, semimove_scorer scorer) const
+{
+    axis_scores_t scores(dimension);
+    for(int n = 0; n < dimension; n++)
+    {
+        scores[n].reserve(axis_coords[n].size());
+        for(const semimove &loc : axis_coords[n])
+        {
+            scores[n].push_back(scorer(loc));
+        }
+    }
+    // upper bound of the scores of all points in hc
+    auto bound = [&scores](const HC &hc) {
+        int b = 0;
+        for(size_t n = 0; n < hc.axes.size(); n++)
+        {
+            int m = std::numeric_limits<int>::min();
+            for(int i : hc.axes[n])
+            {
+                m = std::max(m, scores[n][i]);
+            }
+            b += hc.axes[n].empty() ? 0 : m;
+        }
+        return b;
+    };
+    // max-heap on (bound, seq); among equal bounds the latest one comes first as in search(ss)
+    using item_t = std::tuple<int, size_t, HC>;
+    auto less = [](const item_t &a, const item_t &b) {
+        return std::tie(std::get<0>(a), std::get<1>(a)) < std::tie(std::get<0>(b), std::get<1>(b));
+    };
+    std::vector<item_t> heap;
+    size_t seq = 0;
+    auto push_all = [&](search_space &&new_ss) {
+        for(HC &hc : new_ss.hcs)
+        {
+            int b = bound(hc);
+            heap.emplace_back(b, seq++, std::move(hc));
+            std::push_heap(heap.begin(), heap.end(), less);
+        }
+    };
+    push_all(std::move(ss));
+    while(!heap.empty())
+    {
+        std::pop_heap(heap.begin(), heap.end(), less);
+        HC hc = std::move(std::get<2>(heap.back()));
+        heap.pop_back();
+        dprint("searching ", hc.to_string());
+        auto pt_opt = take_point(hc, &scores);
+        if(pt_opt)
+        {
+            point pt = pt_opt.value();
+            auto problem = find_problem(pt, hc);
+            if(problem)
+            {
+                push_all(hc.remove_slice(problem.value()));
+            }
+            else
+            {
+                co_yield to_action(pt);
+                push_all(hc.remove_point(pt));
+            }
+        }
+    }
+    co_return;
+}
+
+std::vector<moveseq> HC_info::search_parallel(search_space ss, int num_threads, bool deterministic) const
+{
+    if(num_threads <= 0)
+    {
+        num_threads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    }
+    // each worker pops from the back of its own deque (depth first, as in search())
+    // and steals from the front of the others
+    struct work_queue
+    {
+        std::mutex mtx;
+        std::deque<HC> hcs;
+    };
+    std::vector<work_queue> queues(num_threads);
+    std::vector<std::vector<moveseq>> results(num_threads);
+    // number of hypercuboids that are queued or being processed
+    std::atomic<size_t> outstanding = ss.hcs.size();
+    std::atomic<bool> failed = false;
+    std::exception_ptr error;
+    std::mutex error_mtx;
+    int k = 0;
+    for(HC &hc : ss.hcs)
+    {
+        queues[k++ % num_threads].hcs.push_back(std::move(hc));
+    }
+    auto pop = [&](int id) -> std::optional<HC> {
+        {
+            work_queue &q = queues[id];
+            std::lock_guard<std::mutex> lock(q.mtx);
+            if(!q.hcs.empty())
+            {
+                HC hc = std::move(q.hcs.back());
+                q.hcs.pop_back();
+                return hc;
+            }
+        }
+        for(int j = 1; j < num_threads; j++)
+        {
+            work_queue &q = queues[(id + j) % num_threads];
+            std::lock_guard<std::mutex> lock(q.mtx);
+            if(!q.hcs.empty())
+            {
+                HC hc = std::move(q.hcs.front());
+                q.hcs.pop_front();
+                return hc;
+            }
+        }
+        return std::nullopt;
+    };
+    auto push = [&](int id, search_space &&new_ss) {
+        // count the new pieces before the parent is retired, so that outstanding never drops to zero early
+        outstanding += new_ss.hcs.size();
+        work_queue &q = queues[id];
+        std::lock_guard<std::mutex> lock(q.mtx);
+        for(HC &hc : new_ss.hcs)
+        {
+            q.hcs.push_back(std::move(hc));
+        }
+    };
+    auto work = [&](int id) {
+        try
+        {
+            while(outstanding > 0 && !failed)
+            {
+                std::optional<HC> hc_opt = pop(id);
+                if(!hc_opt)
+                {
+                    std::this_thread::yield();
+                    continue;
+                }
+                HC &hc = *hc_opt;
+                auto pt_opt = take_point(hc);
+                if(pt_opt)
+                {
+                    auto problem = find_problem(*pt_opt, hc);
+                    if(problem)
+                    {
+                        push(id, hc.remove_slice(*problem));
+                    }
+                    else
+                    {
+                        results[id].push_back(to_action(*pt_opt));
+                        push(id, hc.remove_point(*pt_opt));
+                    }
+                }
+                outstanding--;
+            }
+        }
+        catch(...)
+        {
+            std::lock_guard<std::mutex> lock(error_mtx);
+            error = std::current_exception();
+            failed = true;
+        }
+    };
+    std::vector<std::thread> workers;
+    for(int id = 1; id < num_threads; id++)
+    {
+        workers.emplace_back(work, id);
+    }
+    work(0);
+    for(std::thread &t : workers)
+    {
+        t.join();
+    }
+    if(error)
+    {
+        std::rethrow_exception(error);
+    }
+    std::vector<moveseq> result;
+    for(auto &r : results)
+    {
+        std::move(r.begin(), r.end(), std::back_inserter(result));
+    }
+    if(deterministic)
+    {
+        std::sort(result.begin(), result.end());
+    }
+    return result;
+}
+
 // /* for debugging only (this version is more friendly with stacktracing) */
 //std::vector<moveseq> HC_info::search1(search_space ss) const
 //{
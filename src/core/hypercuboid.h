@@ -57,6 +57,12 @@ struct null_move
 //AxisLoc
 using semimove = std::variant<physical_move, arriving_move, departing_move, null_move>;
 
+/*
+ A scorer assigns a priority to each semimove; higher scores are searched first.
+ The score of a point in the search space is the sum of scores of its coordinates.
+ */
+using semimove_scorer = std::function<int(const semimove&)>;
+
 [[maybe_unused]]
 static std::string show_semimove(semimove loc)
 {
@@ -92,13 +98,21 @@ class HC_info
     // whereas new_axis, new_axis+1, ..., dimension-1 are the possible branching lines
     // identity: dimension = universe.axes.size() = axis_coords.size()
     const std::vector<int> mandatory_lines;
+    /*
+     Whether every physical check is ruled out without looking at the whole state: the new boards
+     of all semimoves have been tested, and the boards on unplayable lines (which no action changes)
+     have no check. If so, find_checks() only looks for superphysical checks.
+     */
+    const bool physical_checks_filtered;
     
     /*
      take_point(): takes a point in hc while making sure arrives matches departures
      if it finds an arrive with its departure no longer in hc, then this arrives get
      deleted immediately (that's why parameter hc is a non-const reference)
+     if `scores` is given, it prefers the coordinates with highest scores
      */
-    std::optional<point> take_point(HC& hc) const;
+    using axis_scores_t = std::vector<std::vector<int>>; // axis_scores_t[n][i] is the score of axis_coords[n][i]
+    std::optional<point> take_point(HC& hc, const axis_scores_t *scores = nullptr) const;
     std::optional<slice> find_problem(const point& p, const HC& hc) const;
     std::optional<slice> jump_order_consistent(const point& p, const HC& hc) const;
     std::optional<slice> test_present(const point& p, const HC& hc) const;
@@ -106,12 +120,25 @@ class HC_info
     moveseq to_action(const point& p) const;
     
     //private aggregate constructor
-    HC_info(state s, std::map<int, int> lm, std::vector<std::vector<semimove>> crds, HC uni, int ax, int dim, const std::vector<int> pl)
-        : s(std::move(s)), line_to_axis(std::move(lm)), axis_coords(std::move(crds)), universe(std::move(uni)), new_axis(ax), dimension(dim), mandatory_lines(pl) {}
+    HC_info(state s, std::map<int, int> lm, std::vector<std::vector<semimove>> crds, HC uni, int ax, int dim, const std::vector<int> pl, bool pf)
+        : s(std::move(s)), line_to_axis(std::move(lm)), axis_coords(std::move(crds)), universe(std::move(uni)), new_axis(ax), dimension(dim), mandatory_lines(pl), physical_checks_filtered(pf) {}
 
 public:
     static std::tuple<HC_info, search_space> build_HC(const state& s);
     generator<moveseq> search(search_space ss) const;
+    /*
+     search(ss, scorer): same set of actions as search(ss), in approximately descending order of score.
+     Hypercuboids are visited best-first, by the upper bound of the scores of points inside them,
+     and the point taken from each hypercuboid is greedily chosen to have a high score.
+     */
+    generator<moveseq> search(search_space ss, semimove_scorer scorer) const;
+    /*
+     search_parallel(ss, num_threads, deterministic): the same set of actions as search(ss), computed
+     by `num_threads` workers (0 means one per hardware thread) sharing the hypercuboids of `ss`
+     with work stealing. If `deterministic` is set, the result is sorted; otherwise the order
+     depends on thread scheduling.
+     */
+    std::vector<moveseq> search_parallel(search_space ss, int num_threads = 0, bool deterministic = true) const;
     // /* uncomment when debugging */
     //std::vector<moveseq> search1(search_space ss) const;
 };
@@ -1,7 +1,20 @@
 #include <array>
+#include <atomic>
+#include <stdexcept>
 #include "magic.h"
 #include "utils.h"
 
+#if defined(__x86_64__) || defined(_M_X64)
+#define MAGIC_HAS_PEXT
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define BMI2_TARGET
+#else
+#define BMI2_TARGET __attribute__((target("bmi2")))
+#endif
+#endif
+
 constexpr std::array<bitboard_t, BOARD_SIZE> rook_mask = generate_array(std::make_index_sequence<BOARD_SIZE>{}, [](int xy){
     bitboard_t result = 0;
     int x = xy%BOARD_LENGTH, y = xy/BOARD_LENGTH;
@@ -317,7 +330,7 @@ consteval std::array<bitboard_t, rook_data_size> gen_rook_data()
 }
 constexpr auto rook_data = gen_rook_data();
 
-bitboard_t rook_attack(int pos, bitboard_t blocker)
+static bitboard_t plain_rook_attack(int pos, bitboard_t blocker)
 {
     size_t index = ((blocker & rook_mask[pos]) * rook_magic[pos]) >> (64 - rook_shift[pos]);
     return rook_data[index<<(BOARD_BITS*2) | pos];
@@ -361,12 +374,263 @@ consteval std::array<bitboard_t, bishop_data_size> gen_bishop_data()
 }
 constexpr auto bishop_data = gen_bishop_data();
 
-bitboard_t bishop_attack(int pos, bitboard_t blocker)
+static bitboard_t plain_bishop_attack(int pos, bitboard_t blocker)
 {
     size_t index = ((blocker & bishop_mask[pos]) * bishop_magic[pos]) >> (64 - bishop_shift[pos]);
     return bishop_data[index<<(BOARD_BITS*2) | pos];
 }
 
+/*
+ The compact tables are filled from the plain ones at compile time, so that the attacks
+ are generated only once: square `pos` owns the entries [offset[pos], offset[pos+1]).
+ */
+consteval std::array<size_t, BOARD_SIZE+1> gen_offsets(const std::array<int, BOARD_SIZE> &shift)
+{
+    std::array<size_t, BOARD_SIZE+1> offset{};
+    for(int pos = 0; pos < BOARD_SIZE; pos++)
+    {
+        offset[pos+1] = offset[pos] + (size_t(1) << shift[pos]);
+    }
+    return offset;
+}
+constexpr auto rook_offset = gen_offsets(rook_shift);
+constexpr auto bishop_offset = gen_offsets(bishop_shift);
+
+// fancy magic: the same magic index as the plain table
+template<size_t SIZE, size_t PLAIN_SIZE>
+consteval std::array<bitboard_t, SIZE> gen_fancy_data(const std::array<bitboard_t, PLAIN_SIZE> &plain,
+    const std::array<size_t, BOARD_SIZE+1> &offset)
+{
+    std::array<bitboard_t, SIZE> data{};
+    for(int pos = 0; pos < BOARD_SIZE; pos++)
+    {
+        for(size_t index = 0; index < offset[pos+1] - offset[pos]; index++)
+        {
+            data[offset[pos] + index] = plain[index<<(BOARD_BITS*2) | pos];
+        }
+    }
+    return data;
+}
+constexpr auto rook_fancy_data = gen_fancy_data<rook_offset[BOARD_SIZE]>(rook_data, rook_offset);
+constexpr auto bishop_fancy_data = gen_fancy_data<bishop_offset[BOARD_SIZE]>(bishop_data, bishop_offset);
+
+static bitboard_t fancy_rook_attack(int pos, bitboard_t blocker)
+{
+    size_t index = ((blocker & rook_mask[pos]) * rook_magic[pos]) >> (64 - rook_shift[pos]);
+    return rook_fancy_data[rook_offset[pos] + index];
+}
+
+static bitboard_t fancy_bishop_attack(int pos, bitboard_t blocker)
+{
+    size_t index = ((blocker & bishop_mask[pos]) * bishop_magic[pos]) >> (64 - bishop_shift[pos]);
+    return bishop_fancy_data[bishop_offset[pos] + index];
+}
+
+// pext: the index is the blocker bits under the mask, in order; pdep is its inverse
+template<size_t SIZE, size_t PLAIN_SIZE>
+consteval std::array<bitboard_t, SIZE> gen_pext_data(const std::array<bitboard_t, PLAIN_SIZE> &plain,
+    const std::array<size_t, BOARD_SIZE+1> &offset, const std::array<bitboard_t, BOARD_SIZE> &mask,
+    const std::array<bitboard_t, BOARD_SIZE> &magic, const std::array<int, BOARD_SIZE> &shift)
+{
+    std::array<bitboard_t, SIZE> data{};
+    for(int pos = 0; pos < BOARD_SIZE; pos++)
+    {
+        for(size_t index = 0; index < offset[pos+1] - offset[pos]; index++)
+        {
+            bitboard_t submask = 0, rest = mask[pos];
+            for(size_t bit = 1; rest; bit <<= 1, rest &= rest - 1)
+            {
+                if(index & bit)
+                {
+                    submask |= rest & (0 - rest);
+                }
+            }
+            size_t magic_index = (submask * magic[pos]) >> (64 - shift[pos]);
+            data[offset[pos] + index] = plain[magic_index<<(BOARD_BITS*2) | pos];
+        }
+    }
+    return data;
+}
+
+#ifdef MAGIC_HAS_PEXT
+constexpr auto rook_pext_data = gen_pext_data<rook_offset[BOARD_SIZE]>(rook_data, rook_offset, rook_mask, rook_magic, rook_shift);
+constexpr auto bishop_pext_data = gen_pext_data<bishop_offset[BOARD_SIZE]>(bishop_data, bishop_offset, bishop_mask, bishop_magic, bishop_shift);
+
+BMI2_TARGET static bitboard_t pext_rook_attack(int pos, bitboard_t blocker)
+{
+    return rook_pext_data[rook_offset[pos] + _pext_u64(blocker, rook_mask[pos])];
+}
+
+BMI2_TARGET static bitboard_t pext_bishop_attack(int pos, bitboard_t blocker)
+{
+    return bishop_pext_data[bishop_offset[pos] + _pext_u64(blocker, bishop_mask[pos])];
+}
+#endif
+
+/*
+ Kogge-Stone: occluded_fill<S, WRAP>(gen, empty) floods `gen` through the empty squares in the
+ direction of the shift `S` (left if positive), in three doubling steps. `WRAP` excludes the
+ file that a horizontal step would wrap into; the attack is the fill shifted once more.
+ */
+template<int S>
+constexpr bitboard_t shift_by(bitboard_t b)
+{
+    if constexpr (S > 0)
+        return b << S;
+    else
+        return b >> -S;
+}
+
+template<int S, bitboard_t WRAP>
+constexpr bitboard_t occluded_attack(bitboard_t gen, bitboard_t empty)
+{
+    bitboard_t pro = empty & WRAP;
+    gen |= pro & shift_by<S>(gen);
+    pro &= shift_by<S>(pro);
+    gen |= pro & shift_by<2*S>(gen);
+    pro &= shift_by<2*S>(pro);
+    gen |= pro & shift_by<4*S>(gen);
+    return shift_by<S>(gen) & WRAP;
+}
+
+static bitboard_t kogge_stone_rook_attack(int pos, bitboard_t blocker)
+{
+    bitboard_t gen = pmask(pos), empty = ~blocker;
+    return occluded_attack<BOARD_LENGTH, ~bitboard_t(0)>(gen, empty)
+         | occluded_attack<-BOARD_LENGTH, ~bitboard_t(0)>(gen, empty)
+         | occluded_attack<1, ~a_file>(gen, empty)
+         | occluded_attack<-1, ~h_file>(gen, empty);
+}
+
+static bitboard_t kogge_stone_bishop_attack(int pos, bitboard_t blocker)
+{
+    bitboard_t gen = pmask(pos), empty = ~blocker;
+    return occluded_attack<BOARD_LENGTH+1, ~a_file>(gen, empty)
+         | occluded_attack<BOARD_LENGTH-1, ~h_file>(gen, empty)
+         | occluded_attack<-(BOARD_LENGTH-1), ~a_file>(gen, empty)
+         | occluded_attack<-(BOARD_LENGTH+1), ~h_file>(gen, empty);
+}
+
+/*
+ Backend selection. The active backend is read with a relaxed load on every call; the
+ initial value is a portable backend, replaced by PEXT during static initialization if possible.
+ */
+struct slider_impl
+{
+    slider_backend backend;
+    bitboard_t (*rook)(int, bitboard_t);
+    bitboard_t (*bishop)(int, bitboard_t);
+};
+
+constexpr slider_impl plain_impl{slider_backend::PLAIN_MAGIC, plain_rook_attack, plain_bishop_attack};
+constexpr slider_impl fancy_impl{slider_backend::FANCY_MAGIC, fancy_rook_attack, fancy_bishop_attack};
+constexpr slider_impl kogge_stone_impl{slider_backend::KOGGE_STONE, kogge_stone_rook_attack, kogge_stone_bishop_attack};
+#ifdef MAGIC_HAS_PEXT
+constexpr slider_impl pext_impl{slider_backend::PEXT, pext_rook_attack, pext_bishop_attack};
+#endif
+
+static bool cpu_has_bmi2()
+{
+#if !defined(MAGIC_HAS_PEXT)
+    return false;
+#elif defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuidex(info, 7, 0);
+    return info[1] & (1 << 8);
+#else
+    return __builtin_cpu_supports("bmi2");
+#endif
+}
+
+static const slider_impl *find_impl(slider_backend backend)
+{
+    switch(backend)
+    {
+        case slider_backend::PLAIN_MAGIC:
+            return &plain_impl;
+        case slider_backend::FANCY_MAGIC:
+            return &fancy_impl;
+        case slider_backend::KOGGE_STONE:
+            return &kogge_stone_impl;
+        case slider_backend::PEXT:
+#ifdef MAGIC_HAS_PEXT
+            if(cpu_has_bmi2())
+                return &pext_impl;
+#endif
+            return nullptr;
+    }
+    return nullptr;
+}
+
+constinit static std::atomic<const slider_impl*> current_impl{&fancy_impl};
+
+[[maybe_unused]] static const bool default_backend_selected = []() {
+    if(const slider_impl *impl = find_impl(slider_backend::PEXT))
+    {
+        current_impl.store(impl, std::memory_order_relaxed);
+    }
+    return true;
+}();
+
+bitboard_t rook_attack(int pos, bitboard_t blocker)
+{
+    return current_impl.load(std::memory_order_relaxed)->rook(pos, blocker);
+}
+
+bitboard_t bishop_attack(int pos, bitboard_t blocker)
+{
+    return current_impl.load(std::memory_order_relaxed)->bishop(pos, blocker);
+}
+
+slider_backend get_slider_backend()
+{
+    return current_impl.load(std::memory_order_relaxed)->backend;
+}
+
+void set_slider_backend(slider_backend backend)
+{
+    const slider_impl *impl = find_impl(backend);
+    if(impl == nullptr)
+    {
+        throw std::runtime_error(std::string("set_slider_backend(): ") + slider_backend_name(backend) + " is not supported on this CPU");
+    }
+    current_impl.store(impl, std::memory_order_relaxed);
+}
+
+bool slider_backend_supported(slider_backend backend)
+{
+    return find_impl(backend) != nullptr;
+}
+
+std::vector<slider_backend> supported_slider_backends()
+{
+    std::vector<slider_backend> result;
+    for(slider_backend backend : {slider_backend::PLAIN_MAGIC, slider_backend::FANCY_MAGIC, slider_backend::PEXT, slider_backend::KOGGE_STONE})
+    {
+        if(slider_backend_supported(backend))
+        {
+            result.push_back(backend);
+        }
+    }
+    return result;
+}
+
+const char *slider_backend_name(slider_backend backend)
+{
+    switch(backend)
+    {
+        case slider_backend::PLAIN_MAGIC:
+            return "plain_magic";
+        case slider_backend::FANCY_MAGIC:
+            return "fancy_magic";
+        case slider_backend::PEXT:
+            return "pext";
+        case slider_backend::KOGGE_STONE:
+            return "kogge_stone";
+    }
+    return "unknown";
+}
+
 
 bitboard_t queen_attack(int pos, bitboard_t blocker)
 {
@@ -1,10 +1,31 @@
 #ifndef MAGIC_H
 #define MAGIC_H
 
+#include <vector>
 #include "bitboard.h"
 
+/*
+ Sliding piece attacks on a single board: the squares reachable from `pos`, stopping at (and
+ including) the first square of `blocker` in each direction.
+
+ The attacks are computed by one of several interchangeable backends:
+ - PLAIN_MAGIC: magic bitboards with one table per square, sized for the largest mask
+ - FANCY_MAGIC: the same magic numbers with a compact table, each square at its own offset
+ - PEXT: tables indexed by the BMI2 instruction pext (x86-64 only)
+ - KOGGE_STONE: branch-free occluded fills, without any table
+ At startup, PEXT is selected if the CPU supports BMI2 and FANCY_MAGIC otherwise.
+ set_slider_backend() throws std::runtime_error for a backend the CPU does not support.
+ */
+enum class slider_backend {PLAIN_MAGIC, FANCY_MAGIC, PEXT, KOGGE_STONE};
+
 bitboard_t rook_attack(int pos, bitboard_t blocker);
 bitboard_t bishop_attack(int pos, bitboard_t blocker);
 bitboard_t queen_attack(int pos, bitboard_t blocker);
 
+slider_backend get_slider_backend();
+void set_slider_backend(slider_backend backend);
+bool slider_backend_supported(slider_backend backend);
+std::vector<slider_backend> supported_slider_backends();
+const char *slider_backend_name(slider_backend backend);
+
 #endif //MAGIC_H
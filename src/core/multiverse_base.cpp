@@ -1,6 +1,8 @@
 #include "multiverse_base.h"
 #include "utils.h"
 #include "magic.h"
+#include "bitboard4.h"
+#include "board_interner.h"
 #include <regex>
 #include <sstream>
 #include <algorithm>
@@ -9,6 +11,7 @@
 #include <utility>
 #include <initializer_list>
 #include <cassert>
+#include <cstdlib>
 
 /*
  The following static functions describe the correspondence between two coordinate systems: L,T and u,v
@@ -42,26 +45,53 @@ constexpr static std::pair<int, bool> v_to_tc(int v)
     return {v >> 1, static_cast<bool>(v & 1)};
 }
 
+/*
+ board_key(h, u, v): hash contribution of a board with hash `h` located at (u, v)
+ */
+constexpr static uint64_t board_key(uint64_t h, int u, int v)
+{
+    return splitmix64(h ^ splitmix64(static_cast<uint64_t>(u) << 32 | static_cast<uint32_t>(v)));
+}
+
 multiverse::multiverse(std::vector<std::tuple<int, int, bool, std::string>> bds, int size_x, int size_y)
-: size_x(size_x), size_y(size_y), l_min(0), l_max(0)
+: size_x(size_x), size_y(size_y), l_min(0), l_max(0), mhash(0)
 {
     if(bds.empty())
         throw std::runtime_error("multiverse(): Empty input");
     for(const auto& [l, t, c, fen] : bds)
     {
-        insert_board_impl(l, t, c, std::make_shared<board>(fen, size_x, size_y));
+        insert_board_impl(l, t, c, board_interner::canonical(make_board(fen, size_x, size_y)));
     }
+    check_gaps();
+}
+
+multiverse::multiverse(const board_ptrs_t &bds, int size_x, int size_y)
+: size_x(size_x), size_y(size_y), l_min(0), l_max(0), mhash(0)
+{
+    if(bds.empty())
+        throw std::runtime_error("multiverse(): Empty input");
+    for(const auto& [l, t, c, b_ptr] : bds)
+    {
+        if(b_ptr == nullptr)
+            throw std::runtime_error("multiverse(): Null board");
+        insert_board_impl(l, t, c, b_ptr);
+    }
+    check_gaps();
+}
+
+void multiverse::check_gaps() const
+{
     for(int l = l_min; l <= l_max; l++)
     {
-        int u = l_to_u(l);
-        if(boards[u].empty())
+        const timeline &tl = *timelines[l_to_u(l)];
+        if(tl.boards.empty())
             throw std::runtime_error("multiverse(): There is a gap between timelines.");
-        for(int v = timeline_start[u]; v <= timeline_end[u]; v++)
+        for(const std::shared_ptr<board> &b_ptr : tl.boards)
         {
-            if(boards[u][v] == nullptr)
+            if(b_ptr == nullptr)
             {
                 throw std::runtime_error("multiverse(): There is a gap between boards on timeline L"
-                    + std::to_string(u_to_l(u)) + ".");
+                    + std::to_string(l) + ".");
             }
         }
     }
@@ -72,7 +102,7 @@ turn_t multiverse::get_present() const
     int present_v = std::numeric_limits<int>::max();
     for(int l = active_min; l <= active_max; l++)
     {
-        present_v = std::min(present_v, timeline_end[l_to_u(l)]);
+        present_v = std::min(present_v, timelines[l_to_u(l)]->end);
     }
     return v_to_tc(present_v);
 }
@@ -94,36 +124,92 @@ std::pair<int, int> multiverse::get_active_range() const
 
 turn_t multiverse::get_timeline_start(int l) const
 {
-    return v_to_tc(timeline_start[l_to_u(l)]);
+    return v_to_tc(timelines[l_to_u(l)]->start);
 }
 
 turn_t multiverse::get_timeline_end(int l) const
 {
-    return v_to_tc(timeline_end[l_to_u(l)]);
+    return v_to_tc(timelines[l_to_u(l)]->end);
 }
 
-std::shared_ptr<board> multiverse::get_board(int l, int t, bool c) const
+uint64_t multiverse::hash() const
 {
-    try
-    {
-        return this->boards.at(l_to_u(l)).at(tc_to_v(t,c));
-    }
-    catch(const std::out_of_range& ex)
+    return mhash;
+}
+
+const board *multiverse::checked_board_ptr(int l, int t, bool c) const
+{
+    const board *b_ptr = get_board_ptr(l, t, c);
+    if(b_ptr == nullptr)
     {
-		std::cerr << ex.what() << std::endl;
         std::cerr << "In this multiverse object:\n" << to_string();
         std::cerr << "Error: Out of range in multiverse::get_board("
         << l << ", " << t << ", " << c << ")"<< std::endl;
-		throw std::runtime_error("Error: Out of range in multiverse::get_board( " + std::to_string(l) + ", " + std::to_string(t) + ")");
-        return nullptr;
+        throw std::runtime_error("Error: Out of range in multiverse::get_board( " + std::to_string(l) + ", " + std::to_string(t) + ")");
     }
+    return b_ptr;
+}
+
+std::shared_ptr<board> multiverse::get_board(int l, int t, bool c) const
+{
+    checked_board_ptr(l, t, c);
+    const timeline &tl = *timelines[l_to_u(l)];
+    return tl.boards[tc_to_v(t, c) - tl.start];
+}
+
+const std::shared_ptr<multiverse::timeline> &multiverse::empty_timeline()
+{
+    static const std::shared_ptr<timeline> empty = std::make_shared<timeline>();
+    return empty;
+}
+
+multiverse::timeline &multiverse::mutable_timeline(int u)
+{
+    std::shared_ptr<timeline> &tl = timelines[u];
+    // the shared empty timeline is never unique, so it is never modified in place
+    if(tl.use_count() != 1)
+    {
+        tl = std::make_shared<timeline>(*tl);
+    }
+    return *tl;
 }
 
 void multiverse::append_board(int l, const std::shared_ptr<board>& b_ptr)
 {
     int u = l_to_u(l);
-    boards[u].push_back(b_ptr);
-    timeline_end[u]++;
+    timeline &tl = mutable_timeline(u);
+    tl.boards.push_back(b_ptr);
+    tl.end++;
+    mhash ^= board_key(b_ptr->hash(), u, tl.end);
+}
+
+void multiverse::pop_board(int l)
+{
+    if(l < l_min || l > l_max)
+    {
+        throw std::runtime_error("multiverse::pop_board(): No timeline L" + std::to_string(l) + ".");
+    }
+    int u = l_to_u(l);
+    if(timelines[u]->boards.size() == 1)
+    {
+        const auto [l0_min, l0_max] = get_initial_lines_range();
+        if((l != l_min && l != l_max) || (l0_min <= l && l <= l0_max))
+        {
+            throw std::runtime_error("multiverse::pop_board(): Cannot remove timeline L" + std::to_string(l) + ".");
+        }
+        mhash ^= board_key(timelines[u]->boards.back()->hash(), u, timelines[u]->end);
+        timelines[u] = empty_timeline();
+        if(l == l_max)
+            l_max--;
+        else
+            l_min++;
+        update_active_range();
+        return;
+    }
+    timeline &tl = mutable_timeline(u);
+    mhash ^= board_key(tl.boards.back()->hash(), u, tl.end);
+    tl.boards.pop_back();
+    tl.end--;
 }
 
 void multiverse::insert_board_impl(int l, int t, bool c, const std::shared_ptr<board>& b_ptr)
@@ -131,33 +217,41 @@ void multiverse::insert_board_impl(int l, int t, bool c, const std::shared_ptr<b
     int u = l_to_u(l);
     int v = tc_to_v(t, c);
 
-    // if u is too large, resize this->board to accommodate new board
-    // and fill any missing row with empty vector
-    if(u >= static_cast<int>(this->boards.size()))
+    if(v < 0)
+    {
+        throw std::runtime_error("multiverse::insert_board_impl(): Negative time is not supported.");
+    }
+    // if u is too large, resize this->timelines to accommodate new board
+    if(u >= static_cast<int>(this->timelines.size()))
     {
-        this->boards.resize(u+1, std::vector<std::shared_ptr<board>>());
-        this->timeline_start.resize(u+1, std::numeric_limits<int>::max());
-        this->timeline_end.resize(u+1, std::numeric_limits<int>::min());
+        this->timelines.resize(u+1, empty_timeline());
     }
     l_min = std::min(l_min, l);
     l_max = std::max(l_max, l);
-    std::vector<std::shared_ptr<board>> &timeline = this->boards[u];
-    // do the same for v
-    if(v >= static_cast<int>(timeline.size()))
+    timeline &tl = mutable_timeline(u);
+    // extend the stored range [start, end] to contain v
+    if(tl.boards.empty())
     {
-        timeline.resize(v+1, nullptr);
+        tl.start = tl.end = v;
+        tl.boards.push_back(nullptr);
     }
-    else if(v < 0)
+    else if(v < tl.start)
     {
-        throw std::runtime_error("multiverse::insert_board_impl(): Negative time is not supported.");
+        tl.boards.insert(tl.boards.begin(), tl.start - v, nullptr);
+        tl.start = v;
+    }
+    else if(v > tl.end)
+    {
+        tl.boards.resize(v - tl.start + 1, nullptr);
+        tl.end = v;
     }
-    if(timeline[v] != nullptr)
+    std::shared_ptr<board> &slot = tl.boards[v - tl.start];
+    if(slot != nullptr)
     {
         throw std::runtime_error("multiverse::insert_board_impl(): Duplicate definition of the board on L="+std::to_string(l)+" (plain notation), T="+std::to_string(t)+" C="+std::string(c?"b":"w"));
     }
-    timeline[v] = b_ptr;
-    timeline_start[u] = std::min(timeline_start[u], v);
-    timeline_end[u]   = std::max(timeline_end[u],   v);
+    slot = b_ptr;
+    mhash ^= board_key(b_ptr->hash(), u, v);
 }
 
 void multiverse::insert_board(int l, int t, bool c, const std::shared_ptr<board> &b_ptr)
@@ -195,16 +289,16 @@ template<bool SHOW_UMOVE>
 std::vector<std::tuple<int,int,bool,std::string>> multiverse::get_boards() const
 {
     std::vector<std::tuple<int,int,bool,std::string>> result;
-    for(int u = 0; u < static_cast<int>(boards.size()); u++)
+    for(int u = 0; u < static_cast<int>(timelines.size()); u++)
     {
-        const auto& timeline = this->boards[u];
+        const timeline& tl = *this->timelines[u];
         int l = u_to_l(u);
-        for(int v = 0; v < static_cast<int>(timeline.size()); v++)
+        for(int v = tl.start; v <= tl.end; v++)
         {
             const auto [t, c] = v_to_tc(v);
-            if(timeline[v] != nullptr)
+            if(tl.boards[v - tl.start] != nullptr)
             {
-                result.push_back(std::make_tuple(l,t,c,timeline[v]->get_fen<SHOW_UMOVE>()));
+                result.push_back(std::make_tuple(l,t,c,tl.boards[v - tl.start]->get_fen<SHOW_UMOVE>()));
             }
         }
     }
@@ -218,18 +312,18 @@ std::string multiverse::to_string() const
     sstm << "Multiverse present: T" << present << (player?'b':'w') << "\n";
     sstm << "lines range:" << get_lines_range() << "\t";
     sstm << "active range:" << get_active_range() << "\n";
-    for(int u = 0; u < static_cast<int>(this->boards.size()); u++)
+    for(int u = 0; u < static_cast<int>(this->timelines.size()); u++)
     {
-        const auto& timeline = this->boards[u];
+        const timeline& tl = *this->timelines[u];
         int l = u_to_l(u);
-        for(int v = 0; v < static_cast<int>(timeline.size()); v++)
+        for(int v = tl.start; v <= tl.end; v++)
         {
             const auto [t, c] = v_to_tc(v);
-            if(timeline[v] != nullptr)
+            if(tl.boards[v - tl.start] != nullptr)
             {
                 sstm << "L" << l << "T" << t << (c ? 'b' : 'w');
                 sstm << "  aka." << pretty_lt(vec4(0,0,t,l)) << "\n";
-                sstm << timeline[v]->to_string();
+                sstm << tl.boards[v - tl.start]->to_string();
             }
         }
     }
@@ -241,17 +335,41 @@ bool multiverse::inbound(vec4 a, bool color) const
     int l = a.l(), u = l_to_u(l), v = tc_to_v(a.t(), color);
     if(a.outbound() || l < l_min || l > l_max)
         return false;
-    return timeline_start[u] <= v && v <= timeline_end[u];
+    return timelines[u]->start <= v && v <= timelines[u]->end;
+}
+
+bool multiverse::operator==(const multiverse& other) const
+{
+    if(mhash != other.mhash || l_min != other.l_min || l_max != other.l_max
+       || size_x != other.size_x || size_y != other.size_y
+       || get_initial_lines_range() != other.get_initial_lines_range())
+        return false;
+    for(int l = l_min; l <= l_max; l++)
+    {
+        int u = l_to_u(l);
+        if(timelines[u] == other.timelines[u])
+            continue;
+        const timeline &x = *timelines[u], &y = *other.timelines[u];
+        if(x.start != y.start || x.end != y.end)
+            return false;
+        for(size_t i = 0; i < x.boards.size(); i++)
+        {
+            const auto &a = x.boards[i], &b = y.boards[i];
+            if(a != b && !(*a == *b))
+                return false;
+        }
+    }
+    return true;
 }
 
 piece_t multiverse::get_piece(vec4 a, bool color) const
 {
-    return boards[l_to_u(a.l())][tc_to_v(a.t(), color)]->get_piece(a.xy());
+    return get_board_ptr(a.l(), a.t(), color)->get_piece(a.xy());
 }
 
 bool multiverse::get_umove_flag(vec4 a, bool color) const
 {
-    return boards[l_to_u(a.l())][tc_to_v(a.t(), color)]->umove() & pmask(ppos(a.x(),a.y()));
+    return get_board_ptr(a.l(), a.t(), color)->umove() & pmask(ppos(a.x(),a.y()));
 }
 
 
@@ -268,7 +386,7 @@ bool multiverse::get_umove_flag(vec4 a, bool color) const
 template<bool C>
 bitboard_t multiverse::gen_physical_moves(vec4 p) const
 {
-    std::shared_ptr<board> b_ptr = get_board(p.l(), p.t(), C);
+    const board *b_ptr = checked_board_ptr(p.l(), p.t(), C);
     piece_t p_piece = b_ptr->get_piece(p.xy());
     if (b_ptr->umove() & pmask(p.xy()))
     {
@@ -294,6 +412,8 @@ bitboard_t multiverse::gen_physical_moves(vec4 p) const
         GENERATE_MOVES_CASE(BISHOP_B)
         GENERATE_MOVES_CASE(QUEEN_W)
         GENERATE_MOVES_CASE(QUEEN_B)
+        GENERATE_MOVES_CASE(ROYAL_QUEEN_W)
+        GENERATE_MOVES_CASE(ROYAL_QUEEN_B)
         GENERATE_MOVES_CASE(PRINCESS_W)
         GENERATE_MOVES_CASE(PRINCESS_B)
         GENERATE_MOVES_CASE(PAWN_W)
@@ -317,9 +437,9 @@ bitboard_t multiverse::gen_physical_moves(vec4 p) const
     }
 }
 template<bool C>
-movegen_t multiverse::gen_superphysical_moves(vec4 p) const
+bool multiverse::visit_superphysical_moves(vec4 p, move_visitor f) const
 {
-    std::shared_ptr<board> b_ptr = get_board(p.l(), p.t(), C);
+    const board *b_ptr = checked_board_ptr(p.l(), p.t(), C);
     piece_t p_piece = b_ptr->get_piece(p.xy());
     if (b_ptr->umove() & pmask(p.xy()))
     {
@@ -329,7 +449,7 @@ movegen_t multiverse::gen_superphysical_moves(vec4 p) const
     {
 #define GENERATE_MOVES_CASE(PIECE) \
         case PIECE: \
-            return gen_moves_impl<PIECE, C, true>(p);
+            return visit_moves_impl<PIECE, C, true>(p, f);
 
         GENERATE_MOVES_CASE(KING_W)
         GENERATE_MOVES_CASE(KING_B)
@@ -370,9 +490,9 @@ movegen_t multiverse::gen_superphysical_moves(vec4 p) const
     }
 }
 template<bool C>
-movegen_t multiverse::gen_moves(vec4 p) const
+bool multiverse::visit_moves(vec4 p, move_visitor f) const
 {
-    std::shared_ptr<board> b_ptr = get_board(p.l(), p.t(), C);
+    const board *b_ptr = checked_board_ptr(p.l(), p.t(), C);
     piece_t p_piece = b_ptr->get_piece(p.xy());
     if (b_ptr->umove() & pmask(p.xy()))
     {
@@ -382,7 +502,7 @@ movegen_t multiverse::gen_moves(vec4 p) const
     {
 #define GENERATE_MOVES_CASE(PIECE) \
         case PIECE: \
-            return gen_moves_impl<PIECE, C, false>(p);
+            return visit_moves_impl<PIECE, C, false>(p, f);
 
         GENERATE_MOVES_CASE(KING_W)
         GENERATE_MOVES_CASE(KING_B)
@@ -426,17 +546,58 @@ movegen_t multiverse::gen_moves(vec4 p) const
     }
 }
 
-generator<vec4> multiverse::gen_piece_move(vec4 p, bool board_color) const
+template<typename T>
+static generator<T> yield_all(std::vector<T> values)
 {
-    movegen_t gen = board_color ? gen_moves<true>(p) : gen_moves<false>(p);
-    for (const auto& [r, bb] : gen)
+    for(T &x : values)
     {
+        co_yield std::move(x);
+    }
+}
+
+template<bool C>
+movegen_t multiverse::gen_superphysical_moves(vec4 p) const
+{
+    std::vector<std::pair<vec4, bitboard_t>> result;
+    visit_superphysical_moves<C>(p, [&result](vec4 q, bitboard_t bb) {
+        result.emplace_back(q, bb);
+        return false;
+    });
+    return yield_all(std::move(result));
+}
+
+template<bool C>
+movegen_t multiverse::gen_moves(vec4 p) const
+{
+    std::vector<std::pair<vec4, bitboard_t>> result;
+    visit_moves<C>(p, [&result](vec4 q, bitboard_t bb) {
+        result.emplace_back(q, bb);
+        return false;
+    });
+    return yield_all(std::move(result));
+}
+
+bool multiverse::visit_piece_move(vec4 p, bool board_color, fn_ref<bool(vec4)> f) const
+{
+    auto g = [f](vec4 r, bitboard_t bb) {
         for(int pos : marked_pos(bb))
         {
-            vec4 q = vec4(pos, r);
-			co_yield q;
+            if(f(vec4(pos, r)))
+                return true;
         }
-    }
+        return false;
+    };
+    return board_color ? visit_moves<true>(p, g) : visit_moves<false>(p, g);
+}
+
+generator<vec4> multiverse::gen_piece_move(vec4 p, bool board_color) const
+{
+    std::vector<vec4> result;
+    visit_piece_move(p, board_color, [&result](vec4 q) {
+        result.push_back(q);
+        return false;
+    });
+    return yield_all(std::move(result));
 }
 
 constexpr std::initializer_list<vec4> orthogonal_dtls = {
@@ -468,86 +629,163 @@ constexpr std::initializer_list<vec4> double_dtls = {
     vec4(0, 0, -2, 0)
 };
 
-template<bool C>
-std::vector<std::pair<vec4, bitboard_t>> multiverse::gen_purely_sp_rook_moves(vec4 p0) const
+constexpr std::initializer_list<vec4> knight_pure_sp_dtls = {
+    vec4(0, 0, 2, 1), vec4(0, 0, 1, 2), vec4(0, 0, -2, 1), vec4(0, 0, 1, -2),
+    vec4(0, 0, 2, -1), vec4(0, 0, -1, 2), vec4(0, 0, -2, -1), vec4(0, 0, -1, -2)
+};
+
+/*
+ sp_jump: a jump to the board (dt, dl) away, landing on `mask` except for the friendly pieces there.
+ king_sp_jumps[pos] and knight_sp_jumps[pos] list all superphysical jumps of a piece at `pos`,
+ in the order the moves are generated.
+ */
+struct sp_jump
 {
-    std::vector<std::pair<vec4, bitboard_t>> result;
-    std::shared_ptr<board> b0_ptr = get_board(p0.l(), p0.t(), C);
-    bitboard_t lrook = b0_ptr->lrook() & b0_ptr->friendly<C>();
-    for(auto d : orthogonal_dtls)
+    int dt, dl;
+    bitboard_t mask;
+};
+
+// the squares `n` steps away from `pos` in a horizontal or vertical direction, as rook_copy_mask(pos, n)
+constexpr static bitboard_t rook_ring(int pos, int n)
+{
+    bitboard_t a, b, c, d;
+    a = b = c = d = pmask(pos);
+    for(int i = 0; i < n; i++)
     {
-        bitboard_t remaining = lrook;
-        for(vec4 p1 = p0 + d; remaining && inbound(p1, C); p1 = p1 + d)
+        a = shift_north(a);
+        b = shift_south(b);
+        c = shift_west(c);
+        d = shift_east(d);
+    }
+    return a | b | c | d;
+}
+
+template<size_t N>
+constexpr static std::array<sp_jump, N> gen_sp_jumps(std::initializer_list<std::pair<std::initializer_list<vec4>, bitboard_t>> groups)
+{
+    std::array<sp_jump, N> jumps{};
+    size_t i = 0;
+    for(const auto &[dtls, mask] : groups)
+    {
+        for(vec4 d : dtls)
         {
-            std::shared_ptr<board> b1_ptr = get_board(p1.l(), p1.t(), C);
-            remaining &= ~b1_ptr->friendly<C>();
-            if(remaining)
-            {
-                //result[p1.tl()] |= remaining;
-                result.push_back(std::make_pair(p1.tl(), remaining));
-                remaining &= ~b1_ptr->hostile<C>();
-            }
+            jumps[i++] = sp_jump{d.t(), d.l(), mask};
         }
     }
-    return result;
+    return jumps;
 }
 
+constexpr std::array<std::array<sp_jump, 7>, BOARD_SIZE> king_sp_jumps = generate_array(std::make_index_sequence<BOARD_SIZE>{}, [](size_t pos)
+{
+    int p = static_cast<int>(pos);
+    bitboard_t z = pmask(p), h = z | shift_west(z) | shift_east(z);
+    return gen_sp_jumps<7>({{both_dtls, h | shift_north(h) | shift_south(h)}});
+});
+
+constexpr std::array<std::array<sp_jump, 14>, BOARD_SIZE> knight_sp_jumps = generate_array(std::make_index_sequence<BOARD_SIZE>{}, [](size_t pos)
+{
+    int p = static_cast<int>(pos);
+    return gen_sp_jumps<14>({
+        {knight_pure_sp_dtls, pmask(p)},
+        {orthogonal_dtls, rook_ring(p, 2)},
+        {double_dtls, rook_ring(p, 1)}
+    });
+});
+
+template<bool C, size_t N>
+static bool visit_sp_jumps(const multiverse &m, vec4 p, const std::array<sp_jump, N> &jumps, move_visitor f)
+{
+    for(const sp_jump &j : jumps)
+    {
+        const int t = p.t() + j.dt, l = p.l() + j.dl;
+        if(const board *b_ptr = m.get_board_ptr(l, t, C))
+        {
+            bitboard_t bb = j.mask & ~b_ptr->friendly<C>();
+            if(bb && f(vec4(0, 0, t, l), bb))
+                return true;
+        }
+    }
+    return false;
+}
 
 template<bool C>
-std::vector<std::pair<vec4, bitboard_t>> multiverse::gen_purely_sp_bishop_moves(vec4 p0) const
+bool multiverse::scan_sp_rays(vec4 p0, std::initializer_list<vec4> dtls, bitboard_t movers, fn_ref<bool(size_t, int, bitboard_t)> f) const
 {
-    std::vector<std::pair<vec4, bitboard_t>> result;
-    std::shared_ptr<board> b0_ptr = get_board(p0.l(), p0.t(), C);
-    bitboard_t lbishop = b0_ptr->lbishop() & b0_ptr->friendly<C>();
-    for(auto d : diagonal_dtls)
+    for(auto first = dtls.begin(); first != dtls.end(); )
     {
-        bitboard_t remaining = lbishop;
-        for(vec4 p1 = p0 + d; remaining && inbound(p1, C); p1 = p1 + d)
+        const size_t lanes = std::min<size_t>(4, dtls.end() - first);
+        const size_t index = first - dtls.begin();
+        const vec4 zero(0, 0, 0, 0);
+        std::array<vec4, 4> d = {zero, zero, zero, zero}, p1 = {p0, p0, p0, p0};
+        bitboard4::lanes_t init{};
+        for(size_t i = 0; i < lanes; i++)
+        {
+            d[i] = first[i];
+            init[i] = movers;
+        }
+        bitboard4 remaining = bitboard4::load(init);
+        for(int n = 1; ; n++)
         {
-            std::shared_ptr<board> b1_ptr = get_board(p1.l(), p1.t(), C);
-            remaining &= ~b1_ptr->friendly<C>();
-            if(remaining)
+            bitboard4::lanes_t rem = remaining.store(), fri, hos;
+            for(size_t i = 0; i < 4; i++)
             {
-                //result[p1.tl()] |= remaining;
-                result.push_back(std::make_pair(p1.tl(), remaining));
-                remaining &= ~b1_ptr->hostile<C>();
+                p1[i] = p1[i] + d[i];
+                // a missing board blocks the whole lane
+                const board *b_ptr = rem[i] ? get_board_ptr(p1[i].l(), p1[i].t(), C) : nullptr;
+                fri[i] = b_ptr ? b_ptr->friendly<C>() : ~bitboard_t(0);
+                hos[i] = b_ptr ? b_ptr->hostile<C>() : 0;
             }
+            bitboard4 moves = remaining.andnot(bitboard4::load(fri));
+            if(moves.none())
+                break;
+            bitboard4::lanes_t bbs = moves.store();
+            for(size_t i = 0; i < lanes; i++)
+            {
+                if(bbs[i] && f(index + i, n, bbs[i]))
+                    return true;
+            }
+            remaining = moves.andnot(bitboard4::load(hos));
         }
+        first += lanes;
     }
-    return result;
+    return false;
 }
 
-
 template<bool C>
-std::vector<std::pair<vec4, bitboard_t>> multiverse::gen_purely_sp_knight_moves(vec4 p0) const
+bool multiverse::visit_slides(vec4 p, std::initializer_list<vec4> dtls, compound_moves &compound, move_visitor f) const
 {
-    std::vector<std::pair<vec4, bitboard_t>> result;
-    std::shared_ptr<board> b0_ptr = get_board(p0.l(), p0.t(), C);
-    bitboard_t lknight = b0_ptr->lknight() & b0_ptr->friendly<C>();
-    const static std::vector<vec4> knight_pure_sp_delta = {vec4(0, 0, 2, 1), vec4(0, 0, 1, 2), vec4(0, 0, -2, 1), vec4(0, 0, 1, -2),
-        vec4(0, 0, 2, -1), vec4(0, 0, -1, 2), vec4(0, 0, -2, -1), vec4(0, 0, -1, -2)};
-    for(vec4 delta : knight_pure_sp_delta)
-    {
-        vec4 p1 = p0 + delta;
-        if(inbound(p1, C))
+    const size_t merged = compound.dtls.size();
+    const bool stopped = scan_sp_rays<C>(p, dtls, pmask(p.xy()), [&](size_t i, int n, bitboard_t bb) {
+        if(i < merged && n <= BOARD_LENGTH)
         {
-            std::shared_ptr<board> b1_ptr = get_board(p1.l(), p1.t(), C);
-            bitboard_t remaining = lknight;
-            remaining &= ~b1_ptr->friendly<C>();
-            if(remaining)
-            {
-                result.push_back(std::make_pair(p1.tl(), remaining));
-            }
+            bb |= compound.slides[i][n-1];
+            compound.slides[i][n-1] = 0;
+        }
+        return f((p + dtls.begin()[i] * n).tl(), bb);
+    });
+    return stopped || visit_compound(p, compound, f);
+}
+
+bool multiverse::visit_compound(vec4 p, const compound_moves &compound, move_visitor f)
+{
+    for(size_t i = 0; i < compound.dtls.size(); i++)
+    {
+        const vec4 d = compound.dtls.begin()[i];
+        for(int n = 1; n <= BOARD_LENGTH; n++)
+        {
+            bitboard_t bb = compound.slides[i][n-1];
+            if(bb && f((p + d * n).tl(), bb))
+                return true;
         }
     }
-    return result;
+    return false;
 }
 
 
 template<piece_t P, bool C>
 bitboard_t multiverse::gen_physical_moves_impl(vec4 p) const
 {
-	std::shared_ptr<board> b_ptr = get_board(p.l(), p.t(), C);
+	const board *b_ptr = get_board_ptr(p.l(), p.t(), C);
     bitboard_t friendly = b_ptr->friendly<C>();
     bitboard_t hostile = b_ptr->hostile<C>();
     bitboard_t a;
@@ -622,7 +860,7 @@ bitboard_t multiverse::gen_physical_moves_impl(vec4 p) const
             vec4 q = p+vec4(0, 2, -1, 0);
             if(inbound(q, C))
             {
-                std::shared_ptr<board> b1_ptr = get_board(q.l(), q.t(), C);
+                const board *b1_ptr = get_board_ptr(q.l(), q.t(), C);
                 bitboard_t j = s & b1_ptr->umove() & ~friendly & b1_ptr->pawn();
                 a |= shift_south(j);
             }
@@ -646,7 +884,7 @@ bitboard_t multiverse::gen_physical_moves_impl(vec4 p) const
             vec4 q = p+vec4(0, 2, -1, 0);
             if(inbound(q, C))
             {
-                std::shared_ptr<board> b1_ptr = get_board(q.l(), q.t(), C);
+                const board *b1_ptr = get_board_ptr(q.l(), q.t(), C);
                 bitboard_t j = s & b1_ptr->umove() & ~friendly & b1_ptr->pawn();
                 a |= shift_north(j);
             }
@@ -673,72 +911,102 @@ bitboard_t multiverse::gen_physical_moves_impl(vec4 p) const
 }
 
 template<bool C, multiverse::axesmode TL, multiverse::axesmode XY>
-void multiverse::gen_compound_moves(vec4 p, std::map<vec4, bitboard_t>& result) const
+void multiverse::gen_compound_moves(vec4 p, compound_moves &result) const
 {
     int pos = p.xy();
+    // slides farther than the distance to the farthest edge only meet walls
+    const int x = p.x(), y = p.y();
+    const int max_n = std::max({x, size_x - 1 - x, y, size_y - 1 - y});
     bitboard_t occ, fri;
     bitboard_t copy_mask;
     
     constexpr auto deltas = (TL==multiverse::axesmode::ORTHOGONAL) ? orthogonal_dtls : (TL==multiverse::axesmode::DIAGONAL) ? diagonal_dtls : both_dtls;
     
     constexpr auto copy_mask_fn = (XY==multiverse::axesmode::ORTHOGONAL) ? rook_copy_mask : (XY==multiverse::axesmode::DIAGONAL) ? bishop_copy_mask : queen_copy_mask;
+    result.dtls = deltas;
+    result.slides = {};
 
-    for(vec4 d : deltas)
+    // the cone slices of up to four directions are gathered in lockstep, one per lane
+    for(auto first = deltas.begin(); first != deltas.end(); )
     {
-        vec4 q = p;
-        occ = fri = 0;
-        for (int n = 1; n < 8; n++)
+        const size_t lanes = std::min<size_t>(4, deltas.end() - first);
+        const vec4 zero(0, 0, 0, 0);
+        std::array<vec4, 4> d = {zero, zero, zero, zero}, q = {p, p, p, p};
+        std::array<bool, 4> alive = {};
+        for(size_t i = 0; i < lanes; i++)
         {
-            copy_mask = copy_mask_fn(pos, n);
-            q = q + d;
-            // if the corresponding board exists, copy the cone slice
-            if(inbound(q, C))
+            d[i] = first[i];
+            alive[i] = true;
+        }
+        bitboard4 occ4 = bitboard4::broadcast(0), fri4 = bitboard4::broadcast(0);
+        for (int n = 1; n <= max_n; n++)
+        {
+            bitboard4::lanes_t o{}, f{};
+            bool any = false;
+            for(size_t i = 0; i < 4; i++)
             {
-                std::shared_ptr<board> b_ptr = get_board(q.l(), q.t(), C);
-                occ |= copy_mask & b_ptr->occupied();
-                fri |= copy_mask & b_ptr->friendly<C>();
+                if(!alive[i])
+                    continue;
+                q[i] = q[i] + d[i];
+                // if the corresponding board exists, copy the cone slice
+                if(const board *b_ptr = get_board_ptr(q[i].l(), q[i].t(), C))
+                {
+                    o[i] = b_ptr->occupied();
+                    f[i] = b_ptr->friendly<C>();
+                    any = true;
+                }
+                // otherwise, set the cone slice to a blocker of friendly pieces, which prevents the attacking move towards this non-existant board
+                else
+                {
+                    o[i] = f[i] = ~bitboard_t(0);
+                    alive[i] = false;
+                }
             }
-            // otherwise, set the cone slice to a blocker of friendly pieces, which prevents the attacking move towards this non-existant board
-            else
-            {
-                occ |= copy_mask;
-                fri |= copy_mask;
+            bitboard4 copy_mask4 = bitboard4::broadcast(copy_mask_fn(pos, n));
+            occ4 |= bitboard4::load(o) & copy_mask4;
+            fri4 |= bitboard4::load(f) & copy_mask4;
+            if(!any)
                 break;
-            }
         }
-        bitboard_t loc = ~fri;
-        if constexpr (XY == multiverse::axesmode::ORTHOGONAL)
+        bitboard4::lanes_t occs = occ4.store(), fris = fri4.store();
+        for(size_t i = 0; i < lanes; i++)
         {
-            loc &= rook_attack(pos, occ);
-        }
-        else if (XY == multiverse::axesmode::DIAGONAL)
-        {
-            loc &= bishop_attack(pos, occ);
-        }
-        else
-        {
-            loc &= queen_attack(pos, occ);
-        }
-        q = p;
-        for (int n = 1; n < 8; n++)
-        {
-            copy_mask = copy_mask_fn(pos, n);
-            q = q + d;
-            bitboard_t c = loc & copy_mask;
-            if(c)
+            occ = occs[i];
+            fri = fris[i];
+            bitboard_t loc = ~fri;
+            if constexpr (XY == multiverse::axesmode::ORTHOGONAL)
+            {
+                loc &= rook_attack(pos, occ);
+            }
+            else if (XY == multiverse::axesmode::DIAGONAL)
             {
-                result[q.tl()] |= c;
+                loc &= bishop_attack(pos, occ);
             }
             else
             {
-                break;
+                loc &= queen_attack(pos, occ);
+            }
+            auto &slide = result.slides[first - deltas.begin() + i];
+            for (int n = 1; n <= max_n; n++)
+            {
+                copy_mask = copy_mask_fn(pos, n);
+                bitboard_t c = loc & copy_mask;
+                if(c)
+                {
+                    slide[n-1] = c;
+                }
+                else
+                {
+                    break;
+                }
             }
         }
+        first += lanes;
     }
 }
 
 template<piece_t P, bool C, bool ONLY_SP>
-movegen_t multiverse::gen_moves_impl(vec4 p) const
+bool multiverse::visit_moves_impl(vec4 p, move_visitor f) const
 {
     if constexpr (!ONLY_SP)
     {
@@ -746,106 +1014,43 @@ movegen_t multiverse::gen_moves_impl(vec4 p) const
         if(bb)
         {
             // only generate this entry when there is at least one physical move
-            co_yield std::make_pair(p.tl(), bb);
+            if(f(p.tl(), bb))
+                return true;
         }
     }
     if constexpr (P == KING_W || P == KING_B || P == COMMON_KING_W || P == COMMON_KING_B || P == KING_UW || P == KING_UB)
     {
-        for(auto d : both_dtls)
-        {
-            vec4 q = p+d;
-            if(inbound(q, C))
-            {
-                std::shared_ptr<board> b_ptr = get_board(q.l(), q.t(), C);
-                bitboard_t bb = king_jump_attack(p.xy()) & ~b_ptr->friendly<C>();
-                if(bb)
-                {
-                    co_yield std::make_pair(q.tl(), bb);
-                }
-            }
-        }
+        if(visit_sp_jumps<C>(*this, p, king_sp_jumps[p.xy()], f))
+            return true;
     }
     else if constexpr (P == ROOK_W || P == ROOK_B || P == ROOK_UW || P == ROOK_UB)
     {
-        bitboard_t z = pmask(p.xy());
-        for(auto [index, bb] : gen_purely_sp_rook_moves<C>(p))
-        {
-            bitboard_t bb1 = bb & z;
-            if(bb1)
-            {
-                co_yield std::make_pair(index.tl(), bb1);
-            }
-        }
+        compound_moves none{};
+        if(visit_slides<C>(p, orthogonal_dtls, none, f))
+            return true;
     }
     else if constexpr (P == BISHOP_W || P == BISHOP_B)
     {
-        bitboard_t z = pmask(p.xy());
-        for(auto [index, bb] : gen_purely_sp_bishop_moves<C>(p))
-        {
-            bitboard_t bb1 = bb & z;
-            if(bb1)
-            {
-                co_yield std::make_pair(index.tl(), bb1);
-            }
-        }
-        std::map<vec4, bitboard_t> result;
+        compound_moves none{}, result;
+        if(visit_slides<C>(p, diagonal_dtls, none, f))
+            return true;
         gen_compound_moves<C, multiverse::axesmode::ORTHOGONAL, multiverse::axesmode::ORTHOGONAL>(p, result);
-        for(const auto& m : result)
-        {
-            co_yield m;
-        }
+        if(visit_compound(p, result, f))
+            return true;
     }
     else if constexpr (P == PRINCESS_W || P == PRINCESS_B)
     {
-        bitboard_t z = pmask(p.xy());
-        std::map<vec4, bitboard_t> result;
-        for(auto [index, bb] : gen_purely_sp_rook_moves<C>(p))
-        {
-            bitboard_t bb1 = bb & z;
-            if(bb1)
-            {
-                result[index.tl()] |= bb1;
-            }
-        }
-        for(auto [index, bb] : gen_purely_sp_bishop_moves<C>(p))
-        {
-            bitboard_t bb1 = bb & z;
-            if(bb1)
-            {
-                result[index.tl()] |= bb1;
-            }
-        }
+        compound_moves result;
         gen_compound_moves<C, multiverse::axesmode::ORTHOGONAL, multiverse::axesmode::ORTHOGONAL>(p, result);
-        for(const auto x : result)
-        {
-            co_yield x;
-        }
+        if(visit_slides<C>(p, both_dtls, result, f))
+            return true;
     }
     else if constexpr (P == QUEEN_W || P == QUEEN_B || P == ROYAL_QUEEN_W || P == ROYAL_QUEEN_B)
     {
-        bitboard_t z = pmask(p.xy());
-        std::map<vec4, bitboard_t> result;
-        for(auto [index, bb] : gen_purely_sp_rook_moves<C>(p))
-        {
-            bitboard_t bb1 = bb & z;
-            if(bb1)
-            {
-                result[index.tl()] |= bb1;
-            }
-        }
-        for(auto [index, bb] : gen_purely_sp_bishop_moves<C>(p))
-        {
-            bitboard_t bb1 = bb & z;
-            if(bb1)
-            {
-                result[index.tl()] |= bb1;
-            }
-        }
+        compound_moves result;
         gen_compound_moves<C, multiverse::axesmode::BOTH, multiverse::axesmode::BOTH>(p, result);
-        for(const auto x : result)
-        {
-            co_yield x;
-        }
+        if(visit_slides<C>(p, both_dtls, result, f))
+            return true;
     }
     else if constexpr (P == PAWN_W || P == BRAWN_W || P == PAWN_UW || P == BRAWN_UW)
     {
@@ -857,11 +1062,12 @@ movegen_t multiverse::gen_moves_impl(vec4 p) const
             vec4 q = p + d;
             if(inbound(q, C))
             {
-                std::shared_ptr<board> b_ptr = get_board(q.l(), q.t(), C);
+                const board *b_ptr = get_board_ptr(q.l(), q.t(), C);
                 bitboard_t bb = z & b_ptr->hostile<C>();
                 if(bb)
                 {
-                    co_yield std::make_pair(q.tl(), bb);
+                    if(f(q.tl(), bb))
+                        return true;
                 }
             }
         }
@@ -869,7 +1075,7 @@ movegen_t multiverse::gen_moves_impl(vec4 p) const
         vec4 q = p + vec4(0,0,0,-1);
         if(inbound(q, C))
         {
-            std::shared_ptr<board> b_ptr = get_board(q.l(), q.t(), C);
+            const board *b_ptr = get_board_ptr(q.l(), q.t(), C);
             bitboard_t bb = z & ~b_ptr->occupied();
             if(bb)
             {
@@ -879,12 +1085,13 @@ movegen_t multiverse::gen_moves_impl(vec4 p) const
                     vec4 r = q + vec4(0,0,0,-1);
                     if(inbound(r,C))
                     {
-                        std::shared_ptr<board> b1_ptr = get_board(r.l(), r.t(), C);
+                        const board *b1_ptr = get_board_ptr(r.l(), r.t(), C);
                         bitboard_t bc = z & ~b1_ptr->occupied();
                         if(bc)
                         {
                             //result[r.tl()] |= bc;
-                            co_yield std::make_pair(r.tl(), bc);
+                            if(f(r.tl(), bc))
+                                return true;
                         }
                     }
                 }
@@ -897,7 +1104,8 @@ movegen_t multiverse::gen_moves_impl(vec4 p) const
             }
             if(bb)
             {
-                co_yield std::make_pair(q.tl(), bb);
+                if(f(q.tl(), bb))
+                    return true;
             }
         }
         if constexpr(P == BRAWN_W || P == BRAWN_UW)
@@ -908,11 +1116,12 @@ movegen_t multiverse::gen_moves_impl(vec4 p) const
                 vec4 s = p + d;
                 if(inbound(s, C))
                 {
-                    std::shared_ptr<board> b2_ptr = get_board(s.l(), s.t(), C);
+                    const board *b2_ptr = get_board_ptr(s.l(), s.t(), C);
                     bitboard_t bd = shift_north(z) & ~b2_ptr->occupied();
                     if(bd)
                     {
-                        co_yield std::make_pair(s.tl(), bd);
+                        if(f(s.tl(), bd))
+                            return true;
                     }
                 }
             }
@@ -928,11 +1137,12 @@ movegen_t multiverse::gen_moves_impl(vec4 p) const
             vec4 q = p + d;
             if(inbound(q, C))
             {
-                std::shared_ptr<board> b_ptr = get_board(q.l(), q.t(), C);
+                const board *b_ptr = get_board_ptr(q.l(), q.t(), C);
                 bitboard_t bb = z & b_ptr->hostile<C>();
                 if(bb)
                 {
-                    co_yield std::make_pair(q.tl(), bb);
+                    if(f(q.tl(), bb))
+                        return true;
                 }
             }
         }
@@ -941,7 +1151,7 @@ movegen_t multiverse::gen_moves_impl(vec4 p) const
 //        std::cout << p << " " << q << inbound(q,C) << "\n";
         if(inbound(q, C))
         {
-            std::shared_ptr<board> b_ptr = get_board(q.l(), q.t(), C);
+            const board *b_ptr = get_board_ptr(q.l(), q.t(), C);
             bitboard_t bb = z & ~b_ptr->occupied();
             if(bb)
             {
@@ -951,11 +1161,12 @@ movegen_t multiverse::gen_moves_impl(vec4 p) const
                     vec4 r = q + vec4(0,0,0,1);
                     if(inbound(r,C))
                     {
-                        std::shared_ptr<board> b1_ptr = get_board(r.l(), r.t(), C);
+                        const board *b1_ptr = get_board_ptr(r.l(), r.t(), C);
                         bitboard_t bc = z & ~b1_ptr->occupied();
                         if(bc)
                         {
-                            co_yield std::make_pair(r.tl(), bc);
+                            if(f(r.tl(), bc))
+                                return true;
                         }
                     }
                 }
@@ -968,7 +1179,8 @@ movegen_t multiverse::gen_moves_impl(vec4 p) const
             }
             if(bb)
             {
-                co_yield std::make_pair(q.tl(), bb);
+                if(f(q.tl(), bb))
+                    return true;
             }
         }
         if constexpr(P == BRAWN_W || P == BRAWN_UW)
@@ -979,11 +1191,12 @@ movegen_t multiverse::gen_moves_impl(vec4 p) const
                 vec4 s = p + d;
                 if(inbound(s, C))
                 {
-                    std::shared_ptr<board> b2_ptr = get_board(s.l(), s.t(), C);
+                    const board *b2_ptr = get_board_ptr(s.l(), s.t(), C);
                     bitboard_t bd = shift_north(z) & ~b2_ptr->occupied();
                     if(bd)
                     {
-                        co_yield std::make_pair(s.tl(), bd);
+                        if(f(s.tl(), bd))
+                            return true;
                     }
                 }
             }
@@ -991,80 +1204,243 @@ movegen_t multiverse::gen_moves_impl(vec4 p) const
     }
     else if constexpr (P == KNIGHT_W || P == KNIGHT_B)
     {
-        for(auto [index, bb] : gen_purely_sp_knight_moves<C>(p))
-        {
-            bitboard_t bb1 = bb & pmask(p.xy());
-            if(bb1)
-            {
-                co_yield std::make_pair(index.tl(), bb1);
-            }
-        }
-        for(auto d : orthogonal_dtls)
-        {
-            vec4 q = p+d;
-            if(inbound(q, C))
-            {
-                std::shared_ptr<board> b_ptr = get_board(q.l(), q.t(), C);
-                bitboard_t bb = knight_jump1_attack(p.xy()) & ~b_ptr->friendly<C>();
-                if(bb)
-                {
-                    co_yield std::make_pair(q.tl(), bb);
-                }
-            }
-        }
-        for(auto d : double_dtls)
-        {
-            vec4 q = p+d;
-            if(inbound(q, C))
-            {
-                std::shared_ptr<board> b_ptr = get_board(q.l(), q.t(), C);
-                bitboard_t bb = knight_jump2_attack(p.xy()) & ~b_ptr->friendly<C>();
-                if(bb)
-                {
-                    co_yield std::make_pair(q.tl(), bb);
-                }
-            }
-        }
+        if(visit_sp_jumps<C>(*this, p, knight_sp_jumps[p.xy()], f))
+            return true;
     }
     else if constexpr (P == UNICORN_W || P == UNICORN_B)
     {
-        std::map<vec4, bitboard_t> r1, r2;
-        gen_compound_moves<C, multiverse::axesmode::ORTHOGONAL, multiverse::axesmode::DIAGONAL>(p, r1);
-        for(const auto& m : r1)
+        compound_moves result;
+        gen_compound_moves<C, multiverse::axesmode::ORTHOGONAL, multiverse::axesmode::DIAGONAL>(p, result);
+        if(visit_compound(p, result, f))
+            return true;
+        gen_compound_moves<C, multiverse::axesmode::DIAGONAL, multiverse::axesmode::ORTHOGONAL>(p, result);
+        if(visit_compound(p, result, f))
+            return true;
+    }
+    else if constexpr (P == DRAGON_W || P == DRAGON_B)
+    {
+        compound_moves result;
+        gen_compound_moves<C, multiverse::axesmode::DIAGONAL, multiverse::axesmode::DIAGONAL>(p, result);
+        if(visit_compound(p, result, f))
+            return true;
+    }
+    else
+    {
+        std::cerr << "gen_superphysical_moves_impl:" << P << "not implemented" << std::endl;
+    }
+    return false;
+}
+
+template<bool C>
+bool multiverse::can_slide(vec4 p, vec4 u, int n) const
+{
+    vec4 r = p;
+    for(int i = 1; i <= n; i++)
+    {
+        r = r + u;
+        if(!inbound(r, C))
         {
-            co_yield m;
+            return false;
         }
-        gen_compound_moves<C, multiverse::axesmode::DIAGONAL, multiverse::axesmode::ORTHOGONAL>(p, r2);
-        for(const auto& m : r2)
+        const board *b_ptr = get_board_ptr(r.l(), r.t(), C);
+        bitboard_t z = pmask(r.xy());
+        // the squares passed through must be empty, the last one must not be friendly
+        if(z & (i < n ? b_ptr->occupied() : b_ptr->friendly<C>()))
         {
-            co_yield m;
+            return false;
         }
     }
-    else if constexpr (P == DRAGON_W || P == DRAGON_B)
+    return true;
+}
+
+static bool contains(std::initializer_list<vec4> dtls, vec4 d)
+{
+    return std::find(dtls.begin(), dtls.end(), d) != dtls.end();
+}
+
+template<bool C>
+bool multiverse::is_pseudolegal(vec4 p, vec4 q) const
+{
+    if(!inbound(p, C) || !inbound(q, C))
     {
-        std::map<vec4, bitboard_t> result;
-        gen_compound_moves<C, multiverse::axesmode::DIAGONAL, multiverse::axesmode::DIAGONAL>(p, result);
-        for(const auto& m : result)
+        return false;
+    }
+    const board *b_ptr = get_board_ptr(p.l(), p.t(), C);
+    piece_t p_piece = b_ptr->get_piece(p.xy());
+    if(p_piece == NO_PIECE || p_piece == WALL_PIECE || piece_color(p_piece) != C)
+    {
+        return false;
+    }
+    vec4 d = q - p;
+    if(d.t() == 0 && d.l() == 0)
+    {
+        return gen_physical_moves<C>(p) & pmask(q.xy());
+    }
+    const board *b1_ptr = get_board_ptr(q.l(), q.t(), C);
+    if(b1_ptr->friendly<C>() & pmask(q.xy()))
+    {
+        return false;
+    }
+    vec4 d_tl = vec4(0, 0, d.t(), d.l());
+    piece_t name = to_white(piece_name(p_piece));
+    switch(name)
+    {
+        case KING_W:
+        case COMMON_KING_W:
+            return contains(both_dtls, d_tl) && (king_jump_attack(p.xy()) & pmask(q.xy()));
+        case KNIGHT_W:
+            if(d.x() == 0 && d.y() == 0)
+                return contains(knight_pure_sp_dtls, d_tl);
+            if(contains(orthogonal_dtls, d_tl))
+                return knight_jump1_attack(p.xy()) & pmask(q.xy());
+            if(contains(double_dtls, d_tl))
+                return knight_jump2_attack(p.xy()) & pmask(q.xy());
+            return false;
+        case ROOK_W:
+        case BISHOP_W:
+        case PRINCESS_W:
+        case QUEEN_W:
+        case ROYAL_QUEEN_W:
+        case UNICORN_W:
+        case DRAGON_W:
+            break;
+        default:
+            // pawns and brawns: search the generated moves
+            return C ? visit_moves<true>(p, [q](vec4 tl, bitboard_t bb) {
+                return tl == q.tl() && (bb & pmask(q.xy()));
+            }) : visit_moves<false>(p, [q](vec4 tl, bitboard_t bb) {
+                return tl == q.tl() && (bb & pmask(q.xy()));
+            });
+    }
+    /* line pieces: `d` must be `n` times a unit step `u` whose components are in {-1,0,1}
+     the step is classified by the number of its nonzero components on the T,L axes
+     and on the X,Y axes, i.e. the axesmodes of gen_compound_moves()
+     */
+    int n = std::max({std::abs(d.x()), std::abs(d.y()), std::abs(d.t()), std::abs(d.l())});
+    for(int a : {d.x(), d.y(), d.t(), d.l()})
+    {
+        if(a != 0 && std::abs(a) != n)
+            return false;
+    }
+    vec4 u = vec4(d.x() / n, d.y() / n, d.t() / n, d.l() / n);
+    int tl_axes = (u.t() != 0) + (u.l() != 0);
+    int xy_axes = (u.x() != 0) + (u.y() != 0);
+    if(tl_axes == 1 && !contains(orthogonal_dtls, vec4(0, 0, u.t(), u.l())))
+    {
+        // moving forward in time on the same timeline
+        return false;
+    }
+    bool allowed;
+    switch(name)
+    {
+        case ROOK_W:
+            allowed = xy_axes == 0 && tl_axes == 1;
+            break;
+        case BISHOP_W:
+            allowed = (xy_axes == 0 && tl_axes == 2) || (xy_axes == 1 && tl_axes == 1);
+            break;
+        case PRINCESS_W:
+            allowed = xy_axes == 0 || (xy_axes == 1 && tl_axes == 1);
+            break;
+        case UNICORN_W:
+            allowed = xy_axes + tl_axes == 3;
+            break;
+        case DRAGON_W:
+            allowed = xy_axes == 2 && tl_axes == 2;
+            break;
+        default:
+            // queens
+            allowed = true;
+            break;
+    }
+    return allowed && can_slide<C>(p, u, n);
+}
+
+/*
+ unit_step(i): the i-th of the 80 nonzero vectors with components in {-1,0,1}
+ knight_jump(i): the i-th of the 48 vectors with a component of +-2 and another one of +-1
+ */
+constexpr static vec4 unit_step(int i)
+{
+    i += i >= 40; // skip the zero vector
+    return vec4(i % 3 - 1, i / 3 % 3 - 1, i / 9 % 3 - 1, i / 27 - 1);
+}
+
+constexpr static vec4 knight_jump(int i)
+{
+    // 12 ordered pairs of axes, 4 choices of signs
+    constexpr int pairs[12][2] = {{0,1},{0,2},{0,3},{1,0},{1,2},{1,3},{2,0},{2,1},{2,3},{3,0},{3,1},{3,2}};
+    int d[4] = {0, 0, 0, 0};
+    d[pairs[i / 4][0]] = i & 1 ? 2 : -2;
+    d[pairs[i / 4][1]] = i & 2 ? 1 : -1;
+    return vec4(d[0], d[1], d[2], d[3]);
+}
+
+template<bool C>
+bool multiverse::visit_attackers_impl(vec4 q, fn_ref<bool(vec4)> f) const
+{
+    if(!inbound(q, C))
+    {
+        return false;
+    }
+    // a candidate must be a piece of color C on the last board of its timeline
+    auto is_candidate = [this](vec4 r, const board *b_ptr) {
+        return (b_ptr->friendly<C>() & ~b_ptr->wall() & pmask(r.xy()))
+            && timelines[l_to_u(r.l())]->end == tc_to_v(r.t(), C);
+    };
+    // every move other than a knight's is a multiple of a unit step with all squares in between
+    // empty, so only the first piece met on each ray from `q` can make it
+    for(int i = 0; i < 80; i++)
+    {
+        const vec4 u = unit_step(i);
+        for(vec4 r = q - u; inbound(r, C); r = r - u)
         {
-            co_yield m;
+            const board *b_ptr = get_board_ptr(r.l(), r.t(), C);
+            if(b_ptr->occupied() & pmask(r.xy()))
+            {
+                if(is_candidate(r, b_ptr) && is_pseudolegal<C>(r, q) && f(r))
+                    return true;
+                break;
+            }
         }
     }
-    else
+    for(int i = 0; i < 48; i++)
     {
-        std::cerr << "gen_superphysical_moves_impl:" << P << "not implemented" << std::endl;
+        vec4 r = q - knight_jump(i);
+        if(!inbound(r, C))
+            continue;
+        const board *b_ptr = get_board_ptr(r.l(), r.t(), C);
+        if((b_ptr->lknight() & pmask(r.xy())) && is_candidate(r, b_ptr) && is_pseudolegal<C>(r, q) && f(r))
+            return true;
     }
+    return false;
+}
+
+bool multiverse::visit_attackers(vec4 q, bool color, fn_ref<bool(vec4)> f) const
+{
+    return color ? visit_attackers_impl<true>(q, f) : visit_attackers_impl<false>(q, f);
+}
+
+std::vector<vec4> multiverse::attackers_of(vec4 q, bool color) const
+{
+    std::vector<vec4> result;
+    visit_attackers(q, color, [&result](vec4 r) {
+        result.push_back(r);
+        return false;
+    });
+    return result;
 }
 
 template <bool C>
 generator<vec4> multiverse::gen_board_move_impl(vec4 p0) const
 {
-    std::shared_ptr<board> b_ptr = get_board(p0.l(), p0.t(), C);
+    const board *b_ptr = checked_board_ptr(p0.l(), p0.t(), C);
     bitboard_t bb = b_ptr->friendly<C>() & ~b_ptr->wall();
     for(int pos : marked_pos(bb))
     {
         vec4 p = vec4(pos, p0.tl());
         // TODO: optimize code below
-        // note: gen_purely_sp_*_moves for *=rxook,bishop,knight are fixed for the whole board
+        // note: the purely superphysical moves of rooks, bishops and knights are fixed for the whole board
         // but we are calling them for each piece here
         movegen_t gen = C ? gen_moves<true>(p) : gen_moves<false>(p);
         for (const auto& [r, bb] : gen)
@@ -1082,10 +1458,10 @@ generator<vec4> multiverse::gen_board_move_impl(vec4 p0) const
 #define INIT_TEMPLATE(PIECE) \
 template bitboard_t multiverse::gen_physical_moves_impl<PIECE, true>(vec4 p) const; \
 template bitboard_t multiverse::gen_physical_moves_impl<PIECE, false>(vec4 p) const; \
-template movegen_t multiverse::gen_moves_impl<PIECE, true, true>(vec4 p) const; \
-template movegen_t multiverse::gen_moves_impl<PIECE, false, true>(vec4 p) const; \
-template movegen_t multiverse::gen_moves_impl<PIECE, true, false>(vec4 p) const; \
-template movegen_t multiverse::gen_moves_impl<PIECE, false, false>(vec4 p) const;
+template bool multiverse::visit_moves_impl<PIECE, true, true>(vec4 p, move_visitor f) const; \
+template bool multiverse::visit_moves_impl<PIECE, false, true>(vec4 p, move_visitor f) const; \
+template bool multiverse::visit_moves_impl<PIECE, true, false>(vec4 p, move_visitor f) const; \
+template bool multiverse::visit_moves_impl<PIECE, false, false>(vec4 p, move_visitor f) const;
 
 INIT_TEMPLATE(KING_W)
 INIT_TEMPLATE(KING_B)
@@ -1121,20 +1497,14 @@ INIT_TEMPLATE(DRAGON_W)
 INIT_TEMPLATE(DRAGON_B)
 #undef INIT_TEMPLATE
 
-template std::vector<std::pair<vec4, bitboard_t>> multiverse::gen_purely_sp_rook_moves<false>(vec4 p) const;
-template std::vector<std::pair<vec4, bitboard_t>> multiverse::gen_purely_sp_rook_moves<true>(vec4 p) const;
-template std::vector<std::pair<vec4, bitboard_t>> multiverse::gen_purely_sp_bishop_moves<false>(vec4 p) const;
-template std::vector<std::pair<vec4, bitboard_t>> multiverse::gen_purely_sp_bishop_moves<true>(vec4 p) const;
-template std::vector<std::pair<vec4, bitboard_t>> multiverse::gen_purely_sp_knight_moves<false>(vec4 p) const;
-template std::vector<std::pair<vec4, bitboard_t>> multiverse::gen_purely_sp_knight_moves<true>(vec4 p) const;
 
 
-template void multiverse::gen_compound_moves<false, multiverse::axesmode::ORTHOGONAL, multiverse::axesmode::ORTHOGONAL>(vec4 p, std::map<vec4, bitboard_t>& result) const;
-template void multiverse::gen_compound_moves<true, multiverse::axesmode::ORTHOGONAL, multiverse::axesmode::ORTHOGONAL>(vec4 p, std::map<vec4, bitboard_t>& result) const;
-template void multiverse::gen_compound_moves<false, multiverse::axesmode::DIAGONAL, multiverse::axesmode::DIAGONAL>(vec4 p, std::map<vec4, bitboard_t>& result) const;
-template void multiverse::gen_compound_moves<true, multiverse::axesmode::DIAGONAL, multiverse::axesmode::DIAGONAL>(vec4 p, std::map<vec4, bitboard_t>& result) const;
-template void multiverse::gen_compound_moves<false, multiverse::axesmode::BOTH, multiverse::axesmode::BOTH>(vec4 p, std::map<vec4, bitboard_t>& result) const;
-template void multiverse::gen_compound_moves<true, multiverse::axesmode::BOTH, multiverse::axesmode::BOTH>(vec4 p, std::map<vec4, bitboard_t>& result) const;
+template void multiverse::gen_compound_moves<false, multiverse::axesmode::ORTHOGONAL, multiverse::axesmode::ORTHOGONAL>(vec4 p, compound_moves &result) const;
+template void multiverse::gen_compound_moves<true, multiverse::axesmode::ORTHOGONAL, multiverse::axesmode::ORTHOGONAL>(vec4 p, compound_moves &result) const;
+template void multiverse::gen_compound_moves<false, multiverse::axesmode::DIAGONAL, multiverse::axesmode::DIAGONAL>(vec4 p, compound_moves &result) const;
+template void multiverse::gen_compound_moves<true, multiverse::axesmode::DIAGONAL, multiverse::axesmode::DIAGONAL>(vec4 p, compound_moves &result) const;
+template void multiverse::gen_compound_moves<false, multiverse::axesmode::BOTH, multiverse::axesmode::BOTH>(vec4 p, compound_moves &result) const;
+template void multiverse::gen_compound_moves<true, multiverse::axesmode::BOTH, multiverse::axesmode::BOTH>(vec4 p, compound_moves &result) const;
 
 template bitboard_t multiverse::gen_physical_moves<true>(vec4 p) const;
 template bitboard_t multiverse::gen_physical_moves<false>(vec4 p) const;
@@ -1145,6 +1515,15 @@ template movegen_t multiverse::gen_superphysical_moves<false>(vec4 p) const;
 template movegen_t multiverse::gen_moves<true>(vec4 p) const;
 template movegen_t multiverse::gen_moves<false>(vec4 p) const;
 
+template bool multiverse::visit_superphysical_moves<true>(vec4 p, move_visitor f) const;
+template bool multiverse::visit_superphysical_moves<false>(vec4 p, move_visitor f) const;
+
+template bool multiverse::visit_moves<true>(vec4 p, move_visitor f) const;
+template bool multiverse::visit_moves<false>(vec4 p, move_visitor f) const;
+
+template bool multiverse::is_pseudolegal<true>(vec4 p, vec4 q) const;
+template bool multiverse::is_pseudolegal<false>(vec4 p, vec4 q) const;
+
 template std::vector<std::tuple<int,int,bool,std::string>> multiverse::get_boards<true>() const;
 template std::vector<std::tuple<int,int,bool,std::string>> multiverse::get_boards<false>() const;
 
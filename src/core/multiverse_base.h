@@ -11,21 +11,32 @@
 #include <string>
 #include <vector>
 #include <tuple>
+#include <array>
 #include <utility>
 #include <map>
 #include <memory>
+#include <limits>
+#include <string_view>
+#include <initializer_list>
 #include "turn.h"
 #include "board.h"
 #include "vec4.h"
 #include "generator.h"
+#include "fn_ref.h"
 
 using movegen_t = generator<std::pair<vec4, bitboard_t>>;
+/*
+ move_visitor: callback receiving (destination board, destination squares) of pseudolegal moves.
+ Returning true stops the enumeration early.
+ */
+using move_visitor = fn_ref<bool(vec4, bitboard_t)>;
 using boards_info_t = std::tuple<int,int,bool,std::string>; // l, t, color, fen
+using board_ptrs_t = std::vector<std::tuple<int,int,bool,std::shared_ptr<board>>>; // l, t, color, board
 
 /*
  The multiverse class.
 
- Behavior of copying a multiverse object is just copy the vector of vectors of pointers to the boards. It does not perform deep-copy of a board object. (Which is expected.)
+ Timelines are immutable once shared: copying a multiverse object copies one pointer per timeline, and a modifier copies the board pointers of the timeline it changes only if that timeline is still shared with another copy. Board objects are never deep-copied. (Which is expected.)
 
  This is an abstract base class. Two child classes are defined for odd and even timelines respectively.
  */
@@ -34,17 +45,30 @@ class multiverse
 private:
     const int size_x, size_y; // board size
     //const int l0_min, l0_max; // initial timeline range
-    std::vector<std::vector<std::shared_ptr<board>>> boards;
-    // the following data are derivated from boards:
+    /*
+     The boards of a timeline are stored contiguously from its first board on:
+     boards[v - start] is the board at v = 2*t + c, for start <= v <= end.
+     A timeline without boards has start > end.
+     Timelines are shared between copies of a multiverse; use mutable_timeline() to modify one.
+     */
+    struct timeline
+    {
+        int start = std::numeric_limits<int>::max();
+        int end = std::numeric_limits<int>::min();
+        std::vector<std::shared_ptr<board>> boards;
+    };
+    std::vector<std::shared_ptr<timeline>> timelines; // indexed by u, never null
+    // the following data are derivated from timelines:
     int l_min, l_max, active_min, active_max;
-    std::vector<int> timeline_start, timeline_end;
+    // xor of board_key(b->hash(), u, v) over all boards b at (u, v)
+    uint64_t mhash;
     
     // private methods for move generation
     template<piece_t P, bool C>
     bitboard_t gen_physical_moves_impl(vec4 p) const;
 
     template<piece_t P, bool C, bool ONLY_SP>
-    movegen_t gen_moves_impl(vec4 p) const;
+    bool visit_moves_impl(vec4 p, move_visitor f) const;
 
     template<bool C>
     generator<vec4> gen_board_move_impl(vec4 p0) const;
@@ -62,29 +86,73 @@ private:
         - `BOTH` means both of the above
      */
     enum class axesmode {ORTHOGONAL, DIAGONAL, BOTH};
+    /*
+     compound_moves: result of gen_compound_moves(), kept on the stack.
+     slides[i][n-1] holds the destination squares on the board n steps of dtls[i] away
+     (empty past the end of the slide).
+     */
+    struct compound_moves
+    {
+        std::initializer_list<vec4> dtls;
+        std::array<std::array<bitboard_t, BOARD_LENGTH>, 7> slides;
+    };
     template<bool C, axesmode TL, axesmode XY>
-    void gen_compound_moves(vec4 p, std::map<vec4, bitboard_t>& result) const;
+    void gen_compound_moves(vec4 p, compound_moves &result) const;
 
+    /*
+     scan_sp_rays<C>(p0, dtls, movers, f): visit the purely superphysical moves of the line pieces
+     `movers` on `p0` along the directions `dtls`, calling f(i, n, bb) for the squares `bb` that
+     can make n steps of dtls[i]. Up to four rays are walked in lockstep, one per lane of a
+     bitboard4; f returns true to stop.
+     */
     template<bool C>
-    std::vector<std::pair<vec4, bitboard_t>> gen_purely_sp_rook_moves(vec4 p0) const;
-    
+    bool scan_sp_rays(vec4 p0, std::initializer_list<vec4> dtls, bitboard_t movers, fn_ref<bool(size_t, int, bitboard_t)> f) const;
+
+    /*
+     visit_slides<C>(p, dtls, compound, f): visit the superphysical moves of the line piece at `p`:
+     its purely superphysical slides along `dtls`, merged board by board with `compound`, which was
+     generated along the same directions (or a prefix of them).
+     visit_compound(p, compound, f): visit the remaining moves of `compound`.
+     */
     template<bool C>
-    std::vector<std::pair<vec4, bitboard_t>> gen_purely_sp_bishop_moves(vec4 p0) const;
-    
+    bool visit_slides(vec4 p, std::initializer_list<vec4> dtls, compound_moves &compound, move_visitor f) const;
+    static bool visit_compound(vec4 p, const compound_moves &compound, move_visitor f);
+
+    /*
+     can_slide<C>(p, u, n): whether a line piece at `p` can make `n` steps of `u`, i.e. all boards
+     on the way exist, the squares passed through are empty and the destination is not friendly
+     */
     template<bool C>
-    std::vector<std::pair<vec4, bitboard_t>> gen_purely_sp_knight_moves(vec4 p0) const;
+    bool can_slide(vec4 p, vec4 u, int n) const;
+
+    static const std::shared_ptr<timeline> &empty_timeline();
+    // the timeline at `u`, copied first if another multiverse shares it
+    timeline &mutable_timeline(int u);
+    template<bool C>
+    bool visit_attackers_impl(vec4 q, fn_ref<bool(vec4)> f) const;
 
     void insert_board_impl(int l, int t, bool c, const std::shared_ptr<board>& b_ptr);
+    void check_gaps() const;
+    // get_board_ptr() for entry points, throws if there is no such board
+    const board *checked_board_ptr(int l, int t, bool c) const;
 protected:
     virtual std::pair<int,int> calculate_active_range() const = 0;
     void update_active_range(); // for initialization of derived classes only
 public:
     // constructor
     multiverse(std::vector<boards_info_t> boards, int size_x, int size_y);
+    // boards are shared, not copied
+    multiverse(const board_ptrs_t &boards, int size_x, int size_y);
     
     // modifiers
     void insert_board(int l, int t, bool c, const std::shared_ptr<board>& b_ptr);
     void append_board(int l, const std::shared_ptr<board>& b_ptr);
+    /*
+     pop_board(l): remove the last board of timeline `l`, i.e. undo append_board(l, ...) or the
+     insert_board() that created `l`. A timeline left without boards is removed, which is only
+     allowed for the outermost timelines (the ones created last).
+     */
+    void pop_board(int l);
 
     // getters
     std::pair<int, int> get_board_size() const;
@@ -93,8 +161,24 @@ public:
     std::pair<int, int> get_active_range() const;
     turn_t get_timeline_start(int l) const;
     turn_t get_timeline_end(int l) const;
+    uint64_t hash() const;
     
     std::shared_ptr<board> get_board(int l, int t, bool c) const;
+    /*
+     get_board_ptr(l, t, c): the board at (l, t, c) without touching its reference count,
+     or nullptr if there is none. The pointer is valid as long as the board is in this multiverse.
+     */
+    const board *get_board_ptr(int l, int t, bool c) const noexcept
+    {
+        const size_t u = static_cast<size_t>(l >= 0 ? l << 1 : ~(l << 1));
+        const int v = t << 1 | static_cast<int>(c);
+        if(u >= timelines.size())
+            return nullptr;
+        const timeline &tl = *timelines[u];
+        if(v < tl.start || v > tl.end)
+            return nullptr;
+        return tl.boards[v - tl.start].get();
+    }
     
     template<bool SHOW_UMOVE=false>
     std::vector<boards_info_t> get_boards() const;
@@ -112,13 +196,51 @@ public:
     
     // move generation
     template<bool C> bitboard_t gen_physical_moves(vec4 p) const;
+    /*
+     visit_*(p, f): call `f` on the moves of the piece at `p` without allocating a coroutine frame.
+     They return true iff `f` stopped the enumeration. The gen_* versions collect the same moves
+     into a generator, for callers outside the hot paths (UI, Python).
+     */
+    template<bool C> bool visit_superphysical_moves(vec4 p, move_visitor f) const;
+    template<bool C> bool visit_moves(vec4 p, move_visitor f) const;
+    bool visit_piece_move(vec4 p, bool board_color, fn_ref<bool(vec4)> f) const;
     template<bool C> movegen_t gen_superphysical_moves(vec4 p) const;
     template<bool C> movegen_t gen_moves(vec4 p) const;
     generator<vec4> gen_piece_move(vec4 p, bool board_color) const;
+    /*
+     is_pseudolegal<C>(p, q): whether the piece of color `C` at `p` can move to `q`, i.e. `q` is
+     among the moves generated by gen_moves<C>(p). Only the boards along the displacement are
+     examined, except for pawns and brawns whose moves are generated.
+     */
+    template<bool C> bool is_pseudolegal(vec4 p, vec4 q) const;
+    /*
+     attackers_of(q, color): the pieces of `color` on the last boards of their timelines with a
+     pseudolegal move to `q`, which is on a board of `color`. This is the 4D counterpart of
+     board::attacks_to(). The search goes backwards from `q`: it takes the first piece on each ray
+     of the 80 unit steps and the knights a jump away, and confirms each with is_pseudolegal().
+     visit_attackers(q, color, f) calls `f` on them instead, until it returns true.
+     */
+    std::vector<vec4> attackers_of(vec4 q, bool color) const;
+    bool visit_attackers(vec4 q, bool color, fn_ref<bool(vec4)> f) const;
     
     // help functions
     bool inbound(vec4 a, bool color) const;
+    /*
+     Two multiverses are equal iff they have the same boards on the same coordinates.
+     Different hashes are rejected in O(1); otherwise the boards are compared one by one,
+     which is cheap when they share pointers.
+     */
+    bool operator==(const multiverse& other) const;
     virtual std::unique_ptr<multiverse> clone() const = 0;
+    /*
+     serialize(): a versioned binary image of the multiverse (see serialization.cpp for the layout).
+     It stores the raw bitboards of every distinct board once, so loading it costs a copy per board
+     instead of parsing 5DFEN. The image is in native byte order.
+     deserialize(data): rebuild the multiverse (odd or even) from such an image; the boards are
+     interned by the active board_interner. Throws std::runtime_error on malformed data.
+     */
+    std::string serialize() const;
+    static std::unique_ptr<multiverse> deserialize(std::string_view data);
     virtual std::string pretty_l(int l) const = 0;
     virtual std::string pretty_lt(vec4 p0) const = 0;
     virtual ~multiverse() = default;
@@ -7,6 +7,12 @@ multiverse_odd::multiverse_odd(std::vector<boards_info_t> boards, int size_x, in
     update_active_range();
 }
 
+multiverse_odd::multiverse_odd(const board_ptrs_t &boards, int size_x, int size_y)
+    : multiverse(boards, size_x, size_y)
+{
+    update_active_range();
+}
+
 std::pair<int, int> multiverse_odd::calculate_active_range() const
 {
     auto [l_min, l_max] = multiverse::get_lines_range();
@@ -26,6 +32,12 @@ multiverse_even::multiverse_even(std::vector<boards_info_t> boards, int size_x,
     update_active_range();
 }
 
+multiverse_even::multiverse_even(const board_ptrs_t &boards, int size_x, int size_y)
+    : multiverse(boards, size_x, size_y)
+{
+    update_active_range();
+}
+
 std::pair<int, int> multiverse_even::calculate_active_range() const
 {
     auto [l_min, l_max] = multiverse::get_lines_range();
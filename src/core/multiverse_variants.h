@@ -11,6 +11,7 @@ class multiverse_odd : public multiverse
 public:
     using multiverse::multiverse;
     multiverse_odd(std::vector<boards_info_t> boards, int size_x = BOARD_LENGTH, int size_y = BOARD_LENGTH);
+    multiverse_odd(const board_ptrs_t &boards, int size_x = BOARD_LENGTH, int size_y = BOARD_LENGTH);
     std::pair<int, int> get_initial_lines_range() const override
     {
         return std::make_pair(0,0);
@@ -35,6 +36,7 @@ class multiverse_even : public multiverse
 public:
     using multiverse::multiverse;
     multiverse_even(std::vector<boards_info_t> boards, int size_x = BOARD_LENGTH, int size_y = BOARD_LENGTH);
+    multiverse_even(const board_ptrs_t &boards, int size_x = BOARD_LENGTH, int size_y = BOARD_LENGTH);
     std::pair<int, int> get_initial_lines_range() const override
     {
         return std::make_pair(-1,0);
@@ -0,0 +1,171 @@
+#include "pgn_reader.h"
+#include <algorithm>
+#include <cctype>
+#include "pgnparser.h"
+
+pgn_reader::pgn_reader(const std::string &path)
+: file{std::make_unique<mapped_file>(path)}, in(nullptr), chunk_size(0), buf{}, text{file->view()},
+  begin(0), splitter{}, eof(true), count(0)
+{
+    reset_splitter(0);
+}
+
+pgn_reader::pgn_reader(std::istream &in, size_t chunk_size)
+: file{}, in(&in), chunk_size(std::max<size_t>(chunk_size, 1)), buf{}, text{},
+  begin(0), splitter{}, eof(false), count(0)
+{
+    reset_splitter(0);
+}
+
+void pgn_reader::reset_splitter(size_t pos)
+{
+    splitter.scan = pos;
+    splitter.comment_depth = 0;
+    splitter.in_bracket = false;
+    splitter.seen_moves = false;
+    splitter.line_empty = true;
+    splitter.blank_line = false;
+    splitter.bracket_after_blank = false;
+    splitter.bracket_start = pos;
+    splitter.keys.clear();
+}
+
+// ends the current game just before `pos`
+std::string_view pgn_reader::split_at(size_t pos)
+{
+    std::string_view game_text = text.substr(begin, pos - begin);
+    begin = pos;
+    reset_splitter(pos);
+    count++;
+    return game_text;
+}
+
+/*
+ Called for every complete bracket of the current game (without the '[' and ']').
+ Headers are recorded by their key; a header following a blank line after the previous headers,
+ or repeating one of their keys, belongs to the next game. Board lines never start a game.
+ */
+bool pgn_reader::starts_game(std::string_view bracket)
+{
+    size_t quote = bracket.find('"');
+    if(quote == std::string_view::npos)
+        return false;
+    std::string key;
+    for(char c : bracket.substr(0, quote))
+    {
+        if(isspace(static_cast<unsigned char>(c)))
+            break;
+        key += static_cast<char>(tolower(static_cast<unsigned char>(c)));
+    }
+    if(!splitter.keys.empty()
+       && (splitter.bracket_after_blank
+           || std::find(splitter.keys.begin(), splitter.keys.end(), key) != splitter.keys.end()))
+        return true;
+    splitter.keys.push_back(std::move(key));
+    return false;
+}
+
+bool pgn_reader::refill()
+{
+    if(eof)
+        return false;
+    // drop the games already returned, so that only the current one is kept
+    if(begin > 0)
+    {
+        buf.erase(0, begin);
+        splitter.scan -= begin;
+        splitter.bracket_start -= begin;
+        begin = 0;
+    }
+    size_t old_size = buf.size();
+    buf.resize(old_size + chunk_size);
+    in->read(buf.data() + old_size, static_cast<std::streamsize>(chunk_size));
+    size_t n = static_cast<size_t>(in->gcount());
+    buf.resize(old_size + n);
+    text = buf;
+    if(n == 0)
+    {
+        eof = true;
+        return false;
+    }
+    return true;
+}
+
+std::optional<std::string_view> pgn_reader::next_text()
+{
+    do
+    {
+        while(splitter.scan < text.size())
+        {
+            const char c = text[splitter.scan];
+            if(splitter.comment_depth > 0)
+            {
+                if(c == '{')
+                    splitter.comment_depth++;
+                else if(c == '}')
+                    splitter.comment_depth--;
+            }
+            else if(splitter.in_bracket)
+            {
+                if(c == ']')
+                {
+                    splitter.in_bracket = false;
+                    const size_t start = splitter.bracket_start;
+                    if(starts_game(text.substr(start + 1, splitter.scan - start - 1)))
+                        return split_at(start);
+                }
+            }
+            else if(c == '\n')
+            {
+                if(splitter.line_empty)
+                    splitter.blank_line = true;
+                splitter.line_empty = true;
+            }
+            else if(c == '{')
+            {
+                splitter.comment_depth = 1;
+                splitter.line_empty = false;
+            }
+            else if(c == '[')
+            {
+                if(splitter.seen_moves)
+                    return split_at(splitter.scan);
+                splitter.in_bracket = true;
+                splitter.bracket_start = splitter.scan;
+                splitter.bracket_after_blank = splitter.blank_line;
+                splitter.blank_line = false;
+                splitter.line_empty = false;
+            }
+            else if(!isspace(static_cast<unsigned char>(c)))
+            {
+                splitter.seen_moves = true;
+                splitter.line_empty = false;
+            }
+            splitter.scan++;
+        }
+    } while(refill());
+    std::string_view rest = text.substr(begin);
+    begin = text.size();
+    reset_splitter(begin);
+    if(std::all_of(rest.begin(), rest.end(), [](char c){ return isspace(static_cast<unsigned char>(c)); }))
+        return std::nullopt;
+    count++;
+    return rest;
+}
+
+std::optional<pgnparser_ast::game> pgn_reader::next()
+{
+    std::optional<std::string_view> game_text = next_text();
+    if(!game_text)
+        return std::nullopt;
+    pgnparser parser(*game_text);
+    std::optional<pgnparser_ast::game> g = parser.parse_game();
+    if(!g || !parser.at_end())
+        throw parse_error("pgn_reader::next(): failed to parse game #" + std::to_string(count));
+    return g;
+}
+
+size_t pgn_reader::games_read() const
+{
+    return count;
+}
@@ -0,0 +1,75 @@
+// pgn_reader.h
+// iterate over the games of a multi-game 5dpgn file or stream
+
+#ifndef PGN_READER_H
+#define PGN_READER_H
+
+#include <string>
+#include <vector>
+#include <string_view>
+#include <istream>
+#include <memory>
+#include <optional>
+#include "ast.h"
+#include "mapped_file.h"
+
+/*
+ A reader splitting concatenated 5dpgn games and parsing them one at a time.
+
+ A new game starts at the first '[' (header or board) that follows move text of the previous
+ game. Games without moves are ended by a header that follows a blank line after the previous
+ header block, or by a header whose key already appears in the current game. '[' inside comments
+ is ignored. Each game is parsed by its own pgnparser directly from the source text, without
+ copying it:
+ - pgn_reader(path) memory-maps the file (see mapped_file)
+ - pgn_reader(in, chunk_size) reads the stream in chunks and keeps only the unfinished game
+   in memory, so it works on pipes
+
+ next_text() returns the raw text of the next game; the view is invalidated by the next call.
+ next() parses it and throws parse_error if the game cannot be parsed; the following games can
+ still be read after that. Parsed games are move-only, so they are read with
+     while(auto g = reader.next()) { ... }
+ */
+class pgn_reader
+{
+    std::unique_ptr<mapped_file> file;
+    std::istream *in;
+    size_t chunk_size;
+    std::string buf; // unconsumed text read from `in`
+    std::string_view text; // either file->view() or buf
+    size_t begin; // start of the current game in `text`
+    // state of the splitter; `scan` is the next character to look at
+    struct
+    {
+        size_t scan;
+        int comment_depth;
+        bool in_bracket;
+        bool seen_moves;
+        bool line_empty; // nothing but whitespace since the last newline
+        bool blank_line; // a blank line since the last '['
+        bool bracket_after_blank; // the current bracket follows a blank line
+        size_t bracket_start; // position of the current '['
+        std::vector<std::string> keys; // lower-cased header keys of the current game
+    } splitter;
+    bool eof;
+    size_t count;
+
+    bool refill();
+    void reset_splitter(size_t pos);
+    std::string_view split_at(size_t pos);
+    bool starts_game(std::string_view bracket);
+
+public:
+    constexpr static size_t DEFAULT_CHUNK_SIZE = 1 << 16;
+
+    explicit pgn_reader(const std::string &path);
+    explicit pgn_reader(std::istream &in, size_t chunk_size = DEFAULT_CHUNK_SIZE);
+
+    std::optional<std::string_view> next_text();
+    std::optional<pgnparser_ast::game> next();
+
+    // number of games returned so far
+    size_t games_read() const;
+};
+
+#endif /* PGN_READER_H */
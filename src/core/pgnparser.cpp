@@ -27,7 +27,7 @@ std::vector<std::string> views_to_strings(const std::vector<std::string_view>& v
     return result;
 }
 
-pgnparser::pgnparser(std::string msg, bool ck, turn_t start_turn) : check_turn_number(ck), input(msg)
+pgnparser::pgnparser(std::string_view msg, bool ck, turn_t start_turn) : check_turn_number(ck), input(msg)
 {
     buffer.current = input.begin();
     buffer.turn = previous_turn(start_turn);
@@ -196,18 +196,18 @@ void pgnparser::next_token()
         case '!':
         case '?':
         {
-            std::string::iterator start = buffer.current;
+            std::string_view::iterator start = buffer.current;
             buffer.token = EVALUATION_SYM;
             buffer.current++;
-            while(*buffer.current == '?' || *buffer.current == '!')
+            while(buffer.current != input.end() && (*buffer.current == '?' || *buffer.current == '!'))
                 buffer.current++;
-            buffer.comment = std::string_view(start, buffer.current+1);
+            buffer.comment = std::string_view(start, buffer.current);
             dprint("token:EVALUATION_SYM", buffer.comment);
             break;
         }
         case '>':
             buffer.current++;
-            if(*buffer.current == '>')
+            if(buffer.current != input.end() && *buffer.current == '>')
             {
                 buffer.token = BRANCHING_JUMP;
                 buffer.current++;
@@ -225,7 +225,7 @@ void pgnparser::next_token()
             buffer.token = RIGHT_PAREN; dprint("token:RIGHT_PAREN"); buffer.current++; break;
         case '[':
         {
-            std::string::iterator start = buffer.current;
+            std::string_view::iterator start = buffer.current;
             while(*buffer.current != ']')
             {
                 buffer.current++;
@@ -240,7 +240,7 @@ void pgnparser::next_token()
         }
         case '{':
         {
-            std::string::iterator start = buffer.current;
+            std::string_view::iterator start = buffer.current;
             int nest_level = 1;
             while(nest_level > 0)
             {
@@ -908,6 +908,12 @@ std::optional<game> pgnparser::parse_game()
     return game{headers, boards, std::move(*gt_opt)};
 }
 
+bool pgnparser::at_end()
+{
+    parse_comments();
+    return buffer.token == END;
+}
+
 /* ***MATCHER*** */
 
 bool pgnparser::match_absolute_board(absolute_board simple, absolute_board full)
@@ -20,9 +20,9 @@ class pgnparser
 {
 private:
     const bool check_turn_number;
-    std::string input;
+    std::string_view input;
     struct {
-        std::string::iterator current;
+        std::string_view::iterator current;
         pgnparser_ast::token_t token;
         char piece;
         char file;
@@ -32,7 +32,10 @@ private:
     } buffer;
 public:
     
-    pgnparser(std::string msg, bool check_turn_number=true, turn_t start_turn=std::make_pair(1,false));
+    /*
+     The parser does not copy `msg`: the text must outlive the parser. Parsed results own their strings.
+     */
+    pgnparser(std::string_view msg, bool check_turn_number=true, turn_t start_turn=std::make_pair(1,false));
     void next_token();
     void test_lexer();
      
@@ -58,6 +61,8 @@ public:
     std::optional<actions> parse_actions();
     std::optional<gametree> parse_gametree();
     std::optional<game> parse_game();
+    // skip whitespace and comments, then test whether the whole input has been consumed
+    bool at_end();
     
     static bool match_absolute_board(absolute_board simple, absolute_board full);
     static bool match_relative_board(relative_board simple, relative_board full);
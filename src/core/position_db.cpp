@@ -0,0 +1,198 @@
+#include "position_db.h"
+#include <filesystem>
+#include <limits>
+#include <cstring>
+#include "binary_io.h"
+#include "transposition_table.h"
+
+/*
+ File layout (native byte order):
+   char[4] magic "5DDB", uint32 version
+   records, each one:
+     uint32  size of the rest of the record
+     uint64  state hash
+     uint8   match status, uint8 whether there is an action, uint16 number of moves
+     uint64  number of legal actions, or UINT64_MAX if unknown
+     per move: int16 from x, y, t, l, to x, y, t, l, uint16 promotion
+     the state image (state::serialize())
+ */
+constexpr static char DB_MAGIC[4] = {'5', 'D', 'D', 'B'};
+constexpr static uint32_t DB_VERSION = 1;
+constexpr static size_t DB_HEADER_SIZE = 8;
+constexpr static uint64_t UNKNOWN_COUNT = std::numeric_limits<uint64_t>::max();
+
+struct record_view
+{
+    uint64_t hash;
+    position_db::entry e;
+    bool has_action;
+    std::vector<ext_move> moves;
+    std::string_view image;
+};
+
+static record_view parse_record(std::string_view rec)
+{
+    binary_reader r{rec};
+    record_view v;
+    r.get<uint32_t>();
+    v.hash = r.get<uint64_t>();
+    uint8_t status = r.get<uint8_t>();
+    if(status > static_cast<uint8_t>(match_status_t::STALEMATE))
+        throw std::runtime_error("position_db: Corrupted record");
+    v.e.status = static_cast<match_status_t>(status);
+    v.has_action = r.get<uint8_t>();
+    uint16_t n = r.get<uint16_t>();
+    uint64_t count = r.get<uint64_t>();
+    if(count != UNKNOWN_COUNT)
+        v.e.legal_actions = count;
+    for(uint16_t i = 0; i < n; i++)
+    {
+        int16_t c[8];
+        for(int16_t &x : c)
+            x = r.get<int16_t>();
+        piece_t pt = static_cast<piece_t>(r.get<uint16_t>());
+        v.moves.emplace_back(vec4(c[0], c[1], c[2], c[3]), vec4(c[4], c[5], c[6], c[7]), pt);
+    }
+    v.image = rec.substr(r.pos);
+    return v;
+}
+
+static std::string make_record(const state &s, const position_db::entry &e)
+{
+    std::string rec;
+    binary_writer w{rec};
+    std::vector<ext_move> moves = e.best ? e.best->get_moves() : std::vector<ext_move>{};
+    w.put(uint32_t(0)); // patched below
+    w.put(s.hash());
+    w.put(static_cast<uint8_t>(e.status));
+    w.put(static_cast<uint8_t>(e.best.has_value()));
+    w.put(static_cast<uint16_t>(moves.size()));
+    w.put(e.legal_actions ? *e.legal_actions : UNKNOWN_COUNT);
+    for(const ext_move &m : moves)
+    {
+        for(vec4 p : {m.get_from(), m.get_to()})
+        {
+            w.put(static_cast<int16_t>(p.x()));
+            w.put(static_cast<int16_t>(p.y()));
+            w.put(static_cast<int16_t>(p.t()));
+            w.put(static_cast<int16_t>(p.l()));
+        }
+        w.put(static_cast<uint16_t>(m.get_promote()));
+    }
+    rec += s.serialize();
+    uint32_t size = static_cast<uint32_t>(rec.size() - sizeof(uint32_t));
+    std::memcpy(rec.data(), &size, sizeof(size));
+    return rec;
+}
+
+position_db::position_db(const std::string &path)
+: path(path), file{}, mapped_size(DB_HEADER_SIZE), appended{}, out{}, index{}, mtx{}
+{
+    bool fresh = !std::filesystem::exists(path) || std::filesystem::file_size(path) == 0;
+    if(fresh)
+    {
+        std::ofstream header(path, std::ios::binary | std::ios::trunc);
+        header.write(DB_MAGIC, 4);
+        header.write(reinterpret_cast<const char*>(&DB_VERSION), sizeof(DB_VERSION));
+        if(!header)
+            throw std::runtime_error("position_db(): cannot create " + path);
+    }
+    file = std::make_unique<mapped_file>(path);
+    std::string_view data = file->view();
+    if(data.size() < DB_HEADER_SIZE || std::memcmp(data.data(), DB_MAGIC, 4) != 0)
+        throw std::runtime_error("position_db(): not a position database: " + path);
+    uint32_t version;
+    std::memcpy(&version, data.data() + 4, sizeof(version));
+    if(version != DB_VERSION)
+        throw std::runtime_error("position_db(): unsupported version " + std::to_string(version) + " of " + path);
+    // rebuild the index from the record headers
+    size_t pos = DB_HEADER_SIZE;
+    while(data.size() - pos >= sizeof(uint32_t) + sizeof(uint64_t))
+    {
+        uint32_t size;
+        uint64_t hash;
+        std::memcpy(&size, data.data() + pos, sizeof(size));
+        std::memcpy(&hash, data.data() + pos + sizeof(size), sizeof(hash));
+        if(size < sizeof(uint64_t) || size > data.size() - pos - sizeof(uint32_t))
+            break;
+        index.emplace(hash, pos);
+        pos += sizeof(uint32_t) + size;
+    }
+    mapped_size = pos;
+    if(pos != data.size())
+    {
+        // drop the incomplete record, so that new records are appended after the valid ones
+        file.reset();
+        std::filesystem::resize_file(path, pos);
+        file = std::make_unique<mapped_file>(path);
+    }
+    out.open(path, std::ios::binary | std::ios::app);
+    if(!out)
+        throw std::runtime_error("position_db(): cannot open " + path + " for writing");
+}
+
+std::string_view position_db::record_at(size_t offset) const
+{
+    std::string_view data = offset < mapped_size ? file->view().substr(offset)
+                                                 : std::string_view(appended).substr(offset - mapped_size);
+    uint32_t size;
+    std::memcpy(&size, data.data(), sizeof(size));
+    return data.substr(0, sizeof(uint32_t) + size);
+}
+
+std::optional<position_db::entry> position_db::lookup(const state &s) const
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    auto [first, last] = index.equal_range(s.hash());
+    std::optional<entry> found;
+    size_t found_offset = 0;
+    for(auto it = first; it != last; ++it)
+    {
+        // the latest record of a position wins
+        if(found && it->second < found_offset)
+            continue;
+        record_view v = parse_record(record_at(it->second));
+        if(state::deserialize(v.image) != s)
+            continue;
+        if(v.has_action)
+        {
+            v.e.best = action::from_vector(v.moves, s);
+        }
+        found = std::move(v.e);
+        found_offset = it->second;
+    }
+    return found;
+}
+
+void position_db::store(const state &s, const entry &e)
+{
+    std::string rec = make_record(s, e);
+    std::lock_guard<std::mutex> lock(mtx);
+    out.write(rec.data(), static_cast<std::streamsize>(rec.size()));
+    out.flush();
+    if(!out)
+        throw std::runtime_error("position_db::store(): cannot write to " + path);
+    index.emplace(s.hash(), mapped_size + appended.size());
+    appended += rec;
+}
+
+position_db::entry position_db::query(const state &s, bool count_actions)
+{
+    std::optional<entry> cached = lookup(s);
+    if(cached && (!count_actions || cached->legal_actions))
+        return *cached;
+    transposition_table::entry te = transposition_table::compute(s, count_actions);
+    entry e{te.status, te.first_action, std::nullopt};
+    if(count_actions)
+        e.legal_actions = te.actions->size();
+    else if(te.status != match_status_t::PLAYING)
+        e.legal_actions = 0;
+    store(s, e);
+    return e;
+}
+
+size_t position_db::size() const
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    return index.size();
+}
@@ -0,0 +1,69 @@
+// position_db.h
+// persistent store of analysed positions
+
+#ifndef POSITION_DB_H
+#define POSITION_DB_H
+
+#include <string>
+#include <string_view>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include "state.h"
+#include "action.h"
+#include "turn.h"
+#include "mapped_file.h"
+
+/*
+ An append-only file of analysed positions, indexed by state::hash().
+
+ Every record holds the state::serialize() image of a position together with its match status,
+ optionally a best (or first legal) action and the number of legal actions. Opening the database
+ memory-maps the file and rebuilds the hash index by walking the record headers; a partially
+ written record at the end (e.g. after a crash) is cut off. Records stored later are appended to
+ the file and kept in memory until the database is reopened. Storing a position again supersedes
+ the previous record.
+
+ Lookups compare the stored position with the queried one, so hash collisions are harmless.
+ The object is thread-safe; a file must not be opened for writing by several processes at once.
+ */
+class position_db
+{
+public:
+    struct entry
+    {
+        match_status_t status;
+        std::optional<action> best;
+        std::optional<uint64_t> legal_actions;
+    };
+
+private:
+    std::string path;
+    std::unique_ptr<mapped_file> file;
+    size_t mapped_size; // length of the valid records in `file`
+    std::string appended; // records written since opening, at offsets mapped_size + i
+    std::ofstream out;
+    std::unordered_multimap<uint64_t, size_t> index; // hash -> record offset
+    mutable std::mutex mtx;
+
+    std::string_view record_at(size_t offset) const;
+
+public:
+    explicit position_db(const std::string &path);
+
+    std::optional<entry> lookup(const state &s) const;
+    void store(const state &s, const entry &e);
+    /*
+     query(s, count_actions):
+     The stored entry of `s` if there is one (which counted the legal actions, when
+     `count_actions` is set), otherwise compute it with transposition_table::compute, store and return it.
+     */
+    entry query(const state &s, bool count_actions = false);
+
+    // number of records, including superseded ones
+    size_t size() const;
+};
+
+#endif /* POSITION_DB_H */
@@ -0,0 +1,286 @@
+#include "searcher.h"
+#include <algorithm>
+#include <array>
+#include <iterator>
+#include <bit>
+#include <cstdlib>
+#include "hypercuboid.h"
+
+//#define DEBUGMSG
+#include "debug.h"
+
+/*
+ piece values in centipawns, with the bitboard of the pieces of each kind;
+ royal pieces have no value
+ */
+struct piece_weight
+{
+    piece_t piece;
+    int value;
+    bitboard_t (board::*pieces)() const;
+};
+
+constexpr static std::array<piece_weight, 10> piece_weights = {{
+    {PAWN_W, 100, &board::pawn},
+    {BRAWN_W, 150, &board::brawn},
+    {KNIGHT_W, 300, &board::knight},
+    {COMMON_KING_W, 300, &board::common_king},
+    {BISHOP_W, 325, &board::bishop},
+    {UNICORN_W, 250, &board::unicorn},
+    {DRAGON_W, 200, &board::dragon},
+    {ROOK_W, 500, &board::rook},
+    {PRINCESS_W, 800, &board::princess},
+    {QUEEN_W, 950, &board::queen},
+}};
+
+constexpr static int piece_value(piece_t p)
+{
+    const piece_t name = to_white(piece_name(p));
+    for(const piece_weight &w : piece_weights)
+    {
+        if(w.piece == name)
+            return w.value;
+    }
+    // royal pieces and non-pieces
+    return 0;
+}
+
+/*
+ mate scores are stored in the table relative to the node instead of the root
+ */
+constexpr static int to_tt_score(int score, int ply)
+{
+    if(score >= searcher::MATE_SCORE - searcher::MAX_PLY)
+        return score + ply;
+    if(score <= -searcher::MATE_SCORE + searcher::MAX_PLY)
+        return score - ply;
+    return score;
+}
+
+constexpr static int from_tt_score(int score, int ply)
+{
+    if(score >= searcher::MATE_SCORE - searcher::MAX_PLY)
+        return score - ply;
+    if(score <= -searcher::MATE_SCORE + searcher::MAX_PLY)
+        return score + ply;
+    return score;
+}
+
+searcher::searcher(eval_fn eval) : eval(std::move(eval)), tt{}, generation(0), lim{}, nodes(0), stopped(false) {}
+
+int searcher::material_eval(const state &s)
+{
+    auto [present, player] = s.get_present();
+    auto [l_min, l_max] = s.get_lines_range();
+    int score = 0;
+    for(int l = l_min; l <= l_max; l++)
+    {
+        auto [t, c] = s.get_timeline_end(l);
+        const board *b = s.get_board_ptr(l, t, c);
+        auto side = [&b](bitboard_t mask) {
+            int sum = 0;
+            for(const piece_weight &w : piece_weights)
+            {
+                sum += w.value * std::popcount((b->*w.pieces)() & mask);
+            }
+            return sum;
+        };
+        bitboard_t white = b->white() & ~b->black(), black = b->black() & ~b->white();
+        score += side(white) - side(black);
+    }
+    return player ? -score : score;
+}
+
+void searcher::clear()
+{
+    tt.clear();
+}
+
+bool searcher::out_of_budget()
+{
+    if(stopped)
+        return true;
+    if(lim.nodes && nodes >= lim.nodes)
+    {
+        stopped = true;
+    }
+    else if(lim.time.count() && std::chrono::steady_clock::now() - start_time >= lim.time)
+    {
+        stopped = true;
+    }
+    return stopped;
+}
+
+generator<action> searcher::ordered_actions(const state &s, std::optional<action> best) const
+{
+    if(best)
+    {
+        co_yield *best;
+    }
+    auto [present, player] = s.get_present();
+    // prefer semimoves capturing valuable pieces
+    semimove_scorer scorer = [&s, player](const semimove &loc) {
+        return std::visit(overloads {
+            [&](const physical_move &mv) {
+                return piece_value(s.get_piece(mv.m.to, player));
+            },
+            [&](const arriving_move &mv) {
+                return piece_value(s.get_piece(mv.m.to, player));
+            },
+            [](const departing_move &) {
+                return 0;
+            },
+            [](const null_move &) {
+                return 0;
+            },
+        }, loc);
+    };
+    auto [w, ss] = HC_info::build_HC(s);
+    size_t count = 0;
+    for(const moveseq &mvs : w.search(ss, scorer))
+    {
+        std::vector<ext_move> emvs;
+        std::transform(mvs.begin(), mvs.end(), std::back_inserter(emvs), [](full_move m){
+            return ext_move(m);
+        });
+        action act = action::from_vector(emvs, s);
+        if(best && act == *best)
+            continue;
+        co_yield act;
+        if(lim.actions_per_node && ++count >= lim.actions_per_node)
+            break;
+    }
+}
+
+int searcher::negamax(const state &s, int depth, int alpha, int beta, int ply, std::vector<action> &pv)
+{
+    pv.clear();
+    nodes++;
+    uint64_t key = s.hash();
+    std::string image = s.serialize();
+    std::optional<action> best;
+    if(const std::optional<tt_entry> &slot = tt[key % tt.size()]; slot && slot->key == key && slot->image == image)
+    {
+        const tt_entry &e = *slot;
+        best = e.best;
+        int score = from_tt_score(e.score, ply);
+        if(ply > 0 && e.depth >= depth)
+        {
+            if(e.bound == bound_t::EXACT
+               || (e.bound == bound_t::LOWER && score >= beta)
+               || (e.bound == bound_t::UPPER && score <= alpha))
+            {
+                if(e.best)
+                {
+                    pv.push_back(*e.best);
+                }
+                return score;
+            }
+        }
+    }
+    auto no_action_score = [&s, ply]() {
+        auto [t, c] = s.get_present();
+        if(s.phantom().first_check(!c).has_value())
+            return -MATE_SCORE + ply;
+        else
+            return 0;
+    };
+    if(depth <= 0)
+    {
+        // only test whether there is any legal action
+        auto [w, ss] = HC_info::build_HC(s);
+        if(w.search(ss).first().has_value())
+            return eval(s);
+        return no_action_score();
+    }
+    const int alpha0 = alpha;
+    int best_score = -INF_SCORE;
+    std::vector<action> child_pv;
+    bool first = true;
+    // actions are generated lazily, so that a cutoff saves the rest of the enumeration
+    for(const action &act : ordered_actions(s, best))
+    {
+        // the first action is always searched so that every node gets a score
+        if(!first && out_of_budget())
+            break;
+        std::optional<state> t = s.can_apply(act);
+        if(!t)
+        {
+            // a safeguard only: table entries are verified against the state
+            continue;
+        }
+        int score;
+        if(first)
+        {
+            score = -negamax(*t, depth - 1, -beta, -alpha, ply + 1, child_pv);
+        }
+        else
+        {
+            score = -negamax(*t, depth - 1, -alpha - 1, -alpha, ply + 1, child_pv);
+            if(score > alpha && score < beta && !stopped)
+            {
+                score = -negamax(*t, depth - 1, -beta, -alpha, ply + 1, child_pv);
+            }
+        }
+        if(stopped && !first)
+            break;
+        first = false;
+        if(score > best_score)
+        {
+            best_score = score;
+            best = act;
+            pv.clear();
+            pv.push_back(act);
+            pv.insert(pv.end(), child_pv.begin(), child_pv.end());
+        }
+        alpha = std::max(alpha, score);
+        if(alpha >= beta)
+            break;
+    }
+    if(first)
+    {
+        return no_action_score();
+    }
+    if(!stopped)
+    {
+        std::optional<tt_entry> &slot = tt[key % tt.size()];
+        if(!slot || slot->generation != generation || depth >= slot->depth)
+        {
+            bound_t bound = best_score <= alpha0 ? bound_t::UPPER : best_score >= beta ? bound_t::LOWER : bound_t::EXACT;
+            slot = tt_entry{key, std::move(image), generation, depth, to_tt_score(best_score, ply), bound, best};
+        }
+    }
+    return best_score;
+}
+
+searcher::result searcher::search(const state &s, limits l)
+{
+    lim = l;
+    if(tt.empty())
+    {
+        tt.resize(TT_SIZE);
+    }
+    generation++;
+    start_time = std::chrono::steady_clock::now();
+    nodes = 0;
+    stopped = false;
+    result res;
+    for(int depth = 1; depth <= lim.max_depth; depth++)
+    {
+        std::vector<action> pv;
+        int score = negamax(s, depth, -INF_SCORE, INF_SCORE, 0, pv);
+        if(stopped && depth > 1)
+        {
+            // the last iteration is incomplete, keep the previous one
+            break;
+        }
+        res.score = score;
+        res.depth = stopped ? depth - 1 : depth;
+        res.pv = std::move(pv);
+        dprint("depth", depth, "score", score, "nodes", nodes);
+        if(stopped || std::abs(score) >= MATE_SCORE - MAX_PLY)
+            break;
+    }
+    res.nodes = nodes;
+    return res;
+}
@@ -0,0 +1,106 @@
+// searcher.h
+// alpha-beta search over legal actions
+
+#ifndef SEARCHER_H
+#define SEARCHER_H
+
+#include <vector>
+#include <optional>
+#include <functional>
+#include <string>
+#include <chrono>
+#include <cstdint>
+#include "state.h"
+#include "action.h"
+#include "generator.h"
+
+/*
+ The searcher class.
+
+ Iterative deepening negamax with principal variation search (PVS) over legal actions.
+ Each node enumerates its actions lazily with the hypercuboid algorithm (HC_info::search with
+ a scorer), starting with the best action from the transposition table, then preferring captures
+ of valuable pieces, and searches them with a null window after the first one.
+
+ Scores are in centipawns from the perspective of the player to move. A position where the
+ player to move is checkmated scores `-MATE_SCORE + ply`.
+ */
+class searcher
+{
+public:
+    /*
+     eval_fn: static evaluation of a state from the perspective of the player to move
+     */
+    using eval_fn = std::function<int(const state&)>;
+    constexpr static int MATE_SCORE = 1000000;
+    constexpr static int INF_SCORE = MATE_SCORE + 1;
+    constexpr static int MAX_PLY = 1000; // scores within MAX_PLY of MATE_SCORE are mate scores
+
+    struct limits
+    {
+        int max_depth = 3;
+        // zero means unlimited
+        std::chrono::milliseconds time{0};
+        uint64_t nodes = 0;
+        // maximal number of actions generated on a single node, zero means unlimited
+        size_t actions_per_node = 0;
+    };
+
+    struct result
+    {
+        int score = 0;
+        int depth = 0; // depth of the last completed iteration
+        uint64_t nodes = 0;
+        std::vector<action> pv;
+    };
+
+private:
+    enum class bound_t {EXACT, LOWER, UPPER};
+    /*
+     The transposition table is direct-mapped on the state hash. An entry is only used when the
+     state::serialize() image matches too. On a clash, entries of an earlier search are replaced,
+     and within the same search the deeper entry is kept.
+     */
+    struct tt_entry
+    {
+        uint64_t key;
+        std::string image;
+        unsigned generation; // the search that stored the entry
+        int depth;
+        int score;
+        bound_t bound;
+        std::optional<action> best;
+    };
+    constexpr static size_t TT_SIZE = 1 << 16;
+
+    eval_fn eval;
+    std::vector<std::optional<tt_entry>> tt; // allocated by the first search
+    unsigned generation;
+    // per-search variables
+    limits lim;
+    std::chrono::steady_clock::time_point start_time;
+    uint64_t nodes;
+    bool stopped;
+
+    bool out_of_budget();
+    /*
+     ordered_actions(s, best): legal actions of `s`, starting with `best`,
+     followed by the others ordered by HC_info::search(ss, scorer). `s` must outlive the generator.
+     */
+    generator<action> ordered_actions(const state &s, std::optional<action> best) const;
+    int negamax(const state &s, int depth, int alpha, int beta, int ply, std::vector<action> &pv);
+
+public:
+    searcher(eval_fn eval = material_eval);
+
+    result search(const state &s, limits lim);
+    void clear();
+
+    /*
+     material_eval(s):
+     Sum of piece values on the last board of each timeline, for the player to move minus the opponent.
+     */
+    static int material_eval(const state &s);
+};
+
+#endif /* SEARCHER_H */
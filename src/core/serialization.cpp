@@ -0,0 +1,164 @@
+#include "state.h"
+#include "multiverse_variants.h"
+#include "board_interner.h"
+#include <cstring>
+#include <cstdint>
+#include <unordered_map>
+#include "binary_io.h"
+
+/*
+ Binary format (native byte order, all integers fixed-size):
+
+ state image:
+   char[4]  magic "5DST"
+   uint32   version
+   int32    present
+   uint8    player, followed by 3 bytes of padding
+   multiverse image
+
+ multiverse image:
+   char[4]  magic "5DMV"
+   uint32   version
+   uint8    even timelines (0/1), size_x, size_y, one byte of padding
+   int32    l_min, l_max
+   uint32   number of distinct boards N
+   N * board::raw_t  raw bitboards, 8-byte aligned relative to the state image
+   for each timeline l_min..l_max:
+     int32  first and last v = 2*t + c
+     uint32 index of the board at each v in the table above
+
+ Boards shared by several positions (which is the common case, since timelines share their history
+ after a branch) are stored once. A mismatching magic also detects a foreign byte order.
+ */
+constexpr static char MULTIVERSE_MAGIC[4] = {'5', 'D', 'M', 'V'};
+constexpr static char STATE_MAGIC[4] = {'5', 'D', 'S', 'T'};
+constexpr static uint32_t FORMAT_VERSION = 1;
+
+static void expect_header(binary_reader &r, const char (&magic)[4], const char *what)
+{
+    if(std::memcmp(r.take(4), magic, 4) != 0)
+        throw std::runtime_error(std::string("deserialize(): Not a ") + what + " image (or wrong byte order)");
+    uint32_t version = r.get<uint32_t>();
+    if(version != FORMAT_VERSION)
+        throw std::runtime_error("deserialize(): Unsupported format version " + std::to_string(version));
+}
+
+std::string multiverse::serialize() const
+{
+    std::string out;
+    binary_writer w{out};
+    auto [l0_min, l0_max] = get_initial_lines_range();
+    out.append(MULTIVERSE_MAGIC, 4);
+    w.put(FORMAT_VERSION);
+    w.put(static_cast<uint8_t>(l0_min != 0));
+    w.put(static_cast<uint8_t>(size_x));
+    w.put(static_cast<uint8_t>(size_y));
+    w.put(uint8_t(0));
+    w.put(static_cast<int32_t>(l_min));
+    w.put(static_cast<int32_t>(l_max));
+    // number the distinct boards in order of appearance
+    std::unordered_map<const board*, uint32_t> index;
+    std::vector<const board*> table;
+    std::vector<uint32_t> refs;
+    for(int l = l_min; l <= l_max; l++)
+    {
+        auto [t0, c0] = get_timeline_start(l);
+        auto [t1, c1] = get_timeline_end(l);
+        for(int v = t0 << 1 | c0; v <= (t1 << 1 | c1); v++)
+        {
+            const board *b = get_board_ptr(l, v >> 1, v & 1);
+            auto [it, inserted] = index.try_emplace(b, static_cast<uint32_t>(table.size()));
+            if(inserted)
+                table.push_back(b);
+            refs.push_back(it->second);
+        }
+    }
+    w.put(static_cast<uint32_t>(table.size()));
+    out.reserve(out.size() + table.size() * sizeof(board::raw_t) + (l_max - l_min + 1) * 2 * sizeof(int32_t) + refs.size() * sizeof(uint32_t));
+    for(const board *b : table)
+    {
+        w.put(b->to_raw());
+    }
+    auto ref = refs.begin();
+    for(int l = l_min; l <= l_max; l++)
+    {
+        auto [t0, c0] = get_timeline_start(l);
+        auto [t1, c1] = get_timeline_end(l);
+        int v0 = t0 << 1 | c0, v1 = t1 << 1 | c1;
+        w.put(static_cast<int32_t>(v0));
+        w.put(static_cast<int32_t>(v1));
+        out.append(reinterpret_cast<const char*>(&*ref), (v1 - v0 + 1) * sizeof(uint32_t));
+        ref += v1 - v0 + 1;
+    }
+    return out;
+}
+
+std::unique_ptr<multiverse> multiverse::deserialize(std::string_view data)
+{
+    binary_reader r{data};
+    expect_header(r, MULTIVERSE_MAGIC, "multiverse");
+    const bool even = r.get<uint8_t>();
+    const int sx = r.get<uint8_t>(), sy = r.get<uint8_t>();
+    r.get<uint8_t>();
+    if(sx <= 0 || sy <= 0 || sx > BOARD_LENGTH || sy > BOARD_LENGTH)
+        throw std::runtime_error("deserialize(): Invalid board size");
+    const int lo = r.get<int32_t>(), hi = r.get<int32_t>();
+    // the initial timelines are always present
+    if(lo > (even ? -1 : 0) || hi < 0)
+        throw std::runtime_error("deserialize(): Invalid timeline range");
+    const uint32_t n = r.get<uint32_t>();
+    if(n > r.remaining() / sizeof(board::raw_t))
+        throw std::runtime_error("deserialize(): Truncated data");
+    std::vector<std::shared_ptr<board>> table;
+    table.reserve(n);
+    const char *raw_boards = r.take(n * sizeof(board::raw_t));
+    for(uint32_t i = 0; i < n; i++)
+    {
+        board::raw_t raw;
+        std::memcpy(&raw, raw_boards + i * sizeof(board::raw_t), sizeof(board::raw_t));
+        table.push_back(board_interner::canonical(make_board(raw)));
+    }
+    board_ptrs_t bds;
+    for(int l = lo; l <= hi; l++)
+    {
+        const int v0 = r.get<int32_t>(), v1 = r.get<int32_t>();
+        if(v0 < 0 || v0 > v1)
+            throw std::runtime_error("deserialize(): Invalid timeline on L" + std::to_string(l));
+        if(static_cast<size_t>(v1 - v0) >= r.remaining() / sizeof(uint32_t))
+            throw std::runtime_error("deserialize(): Truncated data");
+        for(int v = v0; v <= v1; v++)
+        {
+            uint32_t i = r.get<uint32_t>();
+            if(i >= n)
+                throw std::runtime_error("deserialize(): Board index out of range");
+            bds.emplace_back(l, v >> 1, v & 1, table[i]);
+        }
+    }
+    if(even)
+        return std::make_unique<multiverse_even>(bds, sx, sy);
+    else
+        return std::make_unique<multiverse_odd>(bds, sx, sy);
+}
+
+std::string state::serialize() const
+{
+    std::string out;
+    binary_writer w{out};
+    out.append(STATE_MAGIC, 4);
+    w.put(FORMAT_VERSION);
+    w.put(static_cast<int32_t>(present));
+    w.put(static_cast<uint8_t>(player));
+    out.append(3, '\0');
+    out += m->serialize();
+    return out;
+}
+
+state state::deserialize(std::string_view data)
+{
+    binary_reader r{data};
+    expect_header(r, STATE_MAGIC, "state");
+    int p = r.get<int32_t>();
+    bool c = r.get<uint8_t>();
+    r.take(3);
+    return state(multiverse::deserialize(data.substr(r.pos)), p, c);
+}
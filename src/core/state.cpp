@@ -14,6 +14,10 @@ state::state(multiverse &mtv) noexcept : m(mtv.clone())
     std::tie(present, player) = m->get_present();
 }
 
+state::state(std::unique_ptr<multiverse> mtv, int present, bool player) noexcept
+: m(std::move(mtv)), present(present), player(player)
+{}
+
 state::state(const pgnparser_ast::game &g)
 {
     auto &metadata = g.headers;
@@ -284,22 +288,8 @@ bool state::apply_move(full_move fm, piece_t promote_to)
     {
         auto te = m->get_timeline_end(p.l());
         assert(std::make_pair(p.t(), player) == te && "moves must be made on an active board");
-        auto mvs = player ? m->gen_moves<true>(p) : m->gen_moves<false>(p);
-        //auto it = mvbbs.find(q.tl());
-        const auto &res = mvs.find([&q](const auto &pair){
-            const auto &[tl, bb] = pair;
-            return tl == q.tl();
-        });
         // is it a pseudolegal move?
-        if(res)
-        {
-            bitboard_t bb = res.value().second;
-            if(!(pmask(q.xy()) & bb))
-            {
-                return false;
-            }
-        }
-        else
+        if(!is_pseudolegal(fm))
         {
             return false;
         }
@@ -312,25 +302,28 @@ bool state::apply_move(full_move fm, piece_t promote_to)
     // physical move, no time travel
     if(d.l() == 0 && d.t() == 0)
     {
-        const std::shared_ptr<board>& b_ptr = m->get_board(p.l(), p.t(), player);
+        const board *b_ptr = m->get_board_ptr(p.l(), p.t(), player);
         bitboard_t z = pmask(p.xy());
         const auto &[size_x, size_y] = m->get_board_size();
         // en passant
         if((b_ptr->lpawn()&z) && d.x()!=0 && b_ptr->get_piece(q.xy()) == NO_PIECE)
         {
             dprint(" ... en passant");
-            m->append_board(p.l(), b_ptr
-                            ->replace_piece(ppos(q.x(),p.y()), NO_PIECE)
-                            ->move_piece(p.xy(), q.xy()));
+            m->append_board(p.l(), b_ptr->replace_pieces({
+                {ppos(q.x(),p.y()), NO_PIECE},
+                {q.xy(), b_ptr->get_piece(p.xy())},
+                {p.xy(), NO_PIECE}
+            }));
         }
         // promotion
         else if((b_ptr->lpawn()&z) && (q.y() == 0 || q.y() == size_y - 1))
         {
             dprint(" ... promotion");
             piece_t promoted = player ? to_black(promote_to) : promote_to;
-            m->append_board(p.l(), b_ptr
-                            ->replace_piece(p.xy(), NO_PIECE)
-                            ->replace_piece(q.xy(), promoted));
+            m->append_board(p.l(), b_ptr->replace_pieces({
+                {p.xy(), NO_PIECE},
+                {q.xy(), promoted}
+            }));
         }
         // castling
         else if((b_ptr->king()&z) && abs(d.x()) > 1)
@@ -338,9 +331,12 @@ bool state::apply_move(full_move fm, piece_t promote_to)
             dprint(" ... castling");
             int rook_x1 = d.x() < 0 ? 0 : (size_x - 1); //rook's original x coordinate
             int rook_x2 = q.x() + (d.x() < 0 ? 1 : -1); //rook's new x coordinate
-            m->append_board(p.l(),b_ptr
-                            ->move_piece(ppos(rook_x1, p.y()), ppos(rook_x2,q.y()))
-                            ->move_piece(p.xy(), q.xy()));
+            m->append_board(p.l(), b_ptr->replace_pieces({
+                {ppos(rook_x2, q.y()), b_ptr->get_piece(ppos(rook_x1, p.y()))},
+                {ppos(rook_x1, p.y()), NO_PIECE},
+                {q.xy(), b_ptr->get_piece(p.xy())},
+                {p.xy(), NO_PIECE}
+            }));
         }
         // normal move
         else
@@ -352,13 +348,13 @@ bool state::apply_move(full_move fm, piece_t promote_to)
     // non-branching superphysical move
     else if (std::make_pair(q.t(), player) == m->get_timeline_end(q.l()))
     {
-        const std::shared_ptr<board>& b_ptr = m->get_board(p.l(), p.t(), player);
+        const board *b_ptr = m->get_board_ptr(p.l(), p.t(), player);
         const piece_t& pic = static_cast<piece_t>(piece_name(b_ptr->get_piece(p.xy())));
         m->append_board(p.l(), b_ptr->replace_piece(p.xy(), NO_PIECE));
         
         bitboard_t z = pmask(p.xy());
         const auto &[size_x, size_y] = m->get_board_size();
-        const std::shared_ptr<board>& c_ptr = m->get_board(q.l(), q.t(), player);
+        const board *c_ptr = m->get_board_ptr(q.l(), q.t(), player);
         
         // promotion (only brawns can do)
         if ((b_ptr->lrawn()&z) && (q.y() == 0 || q.y() == size_y - 1))
@@ -377,10 +373,10 @@ bool state::apply_move(full_move fm, piece_t promote_to)
     //branching move
     else
     {
-        const std::shared_ptr<board>& b_ptr = m->get_board(p.l(), p.t(), player);
+        const board *b_ptr = m->get_board_ptr(p.l(), p.t(), player);
         const piece_t& pic = static_cast<piece_t>(piece_name(b_ptr->get_piece(p.xy())));
         m->append_board(p.l(), b_ptr->replace_piece(p.xy(), NO_PIECE));
-        const std::shared_ptr<board>& x_ptr = m->get_board(q.l(), q.t(), player);
+        const board *x_ptr = m->get_board_ptr(q.l(), q.t(), player);
         auto [t, c] = next_turn({q.t(), player});
         
         bitboard_t z = pmask(p.xy());
@@ -425,6 +421,80 @@ bool state::submit()
     return true;
 }
 
+std::vector<int> state::touched_lines(full_move fm) const
+{
+    // the same three cases as in apply_move()
+    vec4 p = fm.from, q = fm.to, d = q - p;
+    if(d.l() == 0 && d.t() == 0)
+        return {p.l()};
+    else if(std::make_pair(q.t(), player) == m->get_timeline_end(q.l()))
+        return {p.l(), q.l()};
+    else
+        return {p.l(), new_line()};
+}
+
+void state::undo(const undo_entry &e)
+{
+    for(auto it = e.lines.rbegin(); it != e.lines.rend(); ++it)
+    {
+        m->pop_board(*it);
+    }
+    present = e.present;
+    player = e.player;
+}
+
+bool state::make_move(full_move fm, piece_t promote_to)
+{
+    undo_entry e{touched_lines(fm), present, player, false};
+    if(!apply_move<false>(fm, promote_to))
+        return false;
+    undo_stack.push_back(std::move(e));
+    return true;
+}
+
+void state::unmake_move()
+{
+    if(undo_stack.empty() || undo_stack.back().is_action)
+        throw std::runtime_error("state::unmake_move(): The last change is not a move made by make_move().");
+    undo(undo_stack.back());
+    undo_stack.pop_back();
+}
+
+bool state::make_action(const action &act)
+{
+    undo_entry e{{}, present, player, true};
+    for(const auto& em : act.get_moves())
+    {
+        std::vector<int> lines = touched_lines(em.fm);
+        if(!apply_move<false>(em.fm, em.promote_to))
+        {
+            undo(e);
+            return false;
+        }
+        e.lines.insert(e.lines.end(), lines.begin(), lines.end());
+    }
+    if(!submit<false>())
+    {
+        undo(e);
+        return false;
+    }
+    undo_stack.push_back(std::move(e));
+    return true;
+}
+
+void state::unmake_action()
+{
+    if(undo_stack.empty() || !undo_stack.back().is_action)
+        throw std::runtime_error("state::unmake_action(): The last change is not an action made by make_action().");
+    undo(undo_stack.back());
+    undo_stack.pop_back();
+}
+
+size_t state::undo_depth() const
+{
+    return undo_stack.size();
+}
+
 state state::phantom() const
 {
     const auto [l_min, l_max] = get_lines_range();
@@ -486,7 +556,7 @@ std::tuple<std::vector<int>, std::vector<int>, std::vector<int>> state::get_time
  **
  */
 
-generator<full_move> state::find_checks(bool c) const
+std::vector<int> state::check_source_lines(bool c) const
 {
     // cannot use get_timeline_status() directly because it only works for current player
     auto [l_min, l_max] = m->get_lines_range();
@@ -501,18 +571,99 @@ generator<full_move> state::find_checks(bool c) const
             lines.push_back(i);
         }
     }
+    return lines;
+}
+
+bool state::visit_checks(bool c, fn_ref<bool(full_move)> f) const
+{
+    std::vector<int> lines = check_source_lines(c);
     if (c)
     {
-        return find_checks_impl<true>(lines);
+        return visit_checks_impl<true>(lines, f);
+    }
+    else
+    {
+        return visit_checks_impl<false>(lines, f);
+    }
+}
+
+std::optional<full_move> state::first_check(bool c) const
+{
+    std::optional<full_move> result;
+    visit_checks(c, [&result](full_move fm) {
+        result = fm;
+        return true;
+    });
+    return result;
+}
+
+std::optional<full_move> state::first_superphysical_check(bool c) const
+{
+    std::optional<full_move> result;
+    auto f = [&result](full_move fm) {
+        result = fm;
+        return true;
+    };
+    std::vector<int> lines = check_source_lines(c);
+    if(c)
+    {
+        visit_checks_impl<true, true>(lines, f);
     }
     else
     {
-        return find_checks_impl<false>(lines);
+        visit_checks_impl<false, true>(lines, f);
+    }
+    return result;
+}
+
+std::optional<full_move> state::first_check_from_royals(bool c) const
+{
+    const std::vector<int> lines = check_source_lines(c);
+    auto [l_min, l_max] = m->get_lines_range();
+    std::optional<full_move> result;
+    for(int l = l_min; l <= l_max; l++)
+    {
+        auto [t0, c0] = m->get_timeline_start(l);
+        auto [t1, c1] = m->get_timeline_end(l);
+        // royal pieces can be captured on every board of color c, not only on the last ones
+        for(int t = t0; t <= t1; t++)
+        {
+            const board *b_ptr = m->get_board_ptr(l, t, c);
+            if(b_ptr == nullptr)
+                continue;
+            bitboard_t royals = b_ptr->royal() & (c ? b_ptr->hostile<true>() : b_ptr->hostile<false>());
+            for(int pos : marked_pos(royals))
+            {
+                vec4 q = vec4(pos, vec4(0, 0, t, l));
+                m->visit_attackers(q, c, [&](vec4 p) {
+                    if(!std::binary_search(lines.begin(), lines.end(), p.l()))
+                        return false;
+                    result = full_move(p, q);
+                    return true;
+                });
+                if(result)
+                    return result;
+            }
+        }
     }
+    return result;
 }
 
-template<bool C>
-generator<full_move> state::find_checks_impl(std::vector<int> lines) const
+generator<full_move> state::find_checks(bool c) const
+{
+    std::vector<full_move> result;
+    visit_checks(c, [&result](full_move fm) {
+        result.push_back(fm);
+        return false;
+    });
+    for(full_move fm : result)
+    {
+        co_yield fm;
+    }
+}
+
+template<bool C, bool ONLY_SP>
+bool state::visit_checks_impl(const std::vector<int> &lines, fn_ref<bool(full_move)> f) const
 {
 //    print_range(__PRETTY_FUNCTION__, lines);
     for (int l : lines)
@@ -520,35 +671,42 @@ generator<full_move> state::find_checks_impl(std::vector<int> lines) const
         // take the active board
         auto [t, c] = m->get_timeline_end(l);
         assert(c == C);
-        std::shared_ptr<board> b_ptr = m->get_board(l, t, C);
+        const board *b_ptr = m->get_board_ptr(l, t, C);
         bitboard_t b_pieces = b_ptr->friendly<C>() & ~b_ptr->wall();
         // for each friendly piece on this board
         for (int src_pos : marked_pos(b_pieces))
         {
             vec4 p = vec4(src_pos, vec4(0,0,t,l));
-            // generate the aviliable moves
-            auto moves = m->gen_moves<C>(p);
-            // for each destination board and bit location
-            for (const auto& [q0, bb] : moves)
-            {
-                std::shared_ptr<board> b1_ptr = m->get_board(q0.l(), q0.t(), C);
+            // for each destination board and bit location of the aviliable moves
+            auto visitor = [this, p, f](vec4 q0, bitboard_t bb) {
                 if (bb)
                 {
                     // if the destination square is royal, this is a check
-                    bitboard_t c_pieces = bb & b1_ptr->royal();
-                    if (c_pieces)
+                    bitboard_t c_pieces = bb & m->get_board_ptr(q0.l(), q0.t(), C)->royal();
+                    for(int dst_pos : marked_pos(c_pieces))
                     {
-                        for(int dst_pos : marked_pos(c_pieces))
-                        {
-                            vec4 q = vec4(dst_pos, q0);
-                            dprint("found check", full_move(p,q), "source:", p);
-                            co_yield full_move(p, q);
-                        }
+                        vec4 q = vec4(dst_pos, q0);
+                        dprint("found check", full_move(p,q), "source:", p);
+                        if(f(full_move(p, q)))
+                            return true;
                     }
                 }
+                return false;
+            };
+            bool stopped;
+            if constexpr (ONLY_SP)
+            {
+                stopped = m->visit_superphysical_moves<C>(p, visitor);
+            }
+            else
+            {
+                stopped = m->visit_moves<C>(p, visitor);
             }
+            if(stopped)
+                return true;
         }
     }
+    return false;
 }
 
 
@@ -582,16 +740,17 @@ std::vector<vec4> state::gen_movable_pieces_impl(std::vector<int> lines) const
         auto [t, c] = get_timeline_end(l);
         const vec4 p0 = vec4(0,0,t,l);
 //        assert(c == C);
-        std::shared_ptr<board> b_ptr = m->get_board(l, t, C);
+        const board *b_ptr = m->get_board_ptr(l, t, C);
         bitboard_t b_pieces = b_ptr->friendly<C>() & ~b_ptr->wall();
         // for each friendly piece on this board
         for (int src_pos : marked_pos(b_pieces))
         {
             vec4 p = vec4(src_pos, p0);
-            // generate the aviliable moves
-            auto moves = m->gen_moves<C>(p);
-            // for each destination board and bit location
-            if(auto info = moves.first())
+            // stop at the first aviliable move
+            bool has_move = m->visit_moves<C>(p, [](vec4, bitboard_t) {
+                return true;
+            });
+            if(has_move)
             {
                 result.push_back(p);
             }
@@ -601,6 +760,16 @@ std::vector<vec4> state::gen_movable_pieces_impl(std::vector<int> lines) const
     return result;
 }
 
+uint64_t state::hash() const
+{
+    return m->hash() ^ splitmix64(static_cast<uint64_t>(static_cast<uint32_t>(present)) << 1 | static_cast<uint64_t>(player));
+}
+
+bool state::operator==(const state& other) const
+{
+    return present == other.present && player == other.player && *m == *other.m;
+}
+
 std::pair<int, int> state::get_board_size() const
 {
     return m->get_board_size();
@@ -652,6 +821,11 @@ std::shared_ptr<board> state::get_board(int l, int t, bool c) const
     return m->get_board(l, t, c);
 }
 
+const board *state::get_board_ptr(int l, int t, bool c) const noexcept
+{
+    return m->get_board_ptr(l, t, c);
+}
+
 std::vector<std::tuple<int, int, bool, std::string>> state::get_boards() const
 {
     return m->get_boards();
@@ -667,6 +841,21 @@ generator<vec4> state::gen_piece_move(vec4 p, bool c) const
     return m->gen_piece_move(p, c);
 }
 
+bool state::visit_piece_move(vec4 p, fn_ref<bool(vec4)> f) const
+{
+    return m->visit_piece_move(p, player, f);
+}
+
+std::vector<vec4> state::attackers_of(vec4 q, bool c) const
+{
+    return m->attackers_of(q, c);
+}
+
+bool state::is_pseudolegal(full_move fm) const
+{
+    return player ? m->is_pseudolegal<true>(fm.from, fm.to) : m->is_pseudolegal<false>(fm.from, fm.to);
+}
+
 std::string state::to_string() const
 {
     std::ostringstream ss;
@@ -685,6 +874,43 @@ std::string state::show_fen() const
     return oss.str();
 }
 
+/*
+ board_ast(m, p0): the board (L,T) of `p0` as an AST, exactly as pgnparser reads the output of
+ multiverse::pretty_lt(p0)
+ */
+static pgnparser_ast::absolute_board board_ast(const multiverse &m, vec4 p0)
+{
+    using namespace pgnparser_ast;
+    int l = p0.l();
+    bool even = m.get_initial_lines_range().first != 0;
+    if(even)
+    {
+        return absolute_board{l >= 0 ? POSITIVE : NEGATIVE, l >= 0 ? l : ~l, p0.t()};
+    }
+    return absolute_board{l < 0 ? NEGATIVE : NIL, l < 0 ? -l : l, p0.t()};
+}
+
+/*
+ Whether a pawn can promote to the piece named `pt`: any piece but kings, royal queens and pawns.
+ The fairy pieces are accepted in every variant, since variants do not restrict the piece set.
+ */
+static bool is_promotion_piece(char pt)
+{
+    switch(pt)
+    {
+        case QUEEN_W: case ROOK_W: case BISHOP_W: case KNIGHT_W:
+        case PRINCESS_W: case UNICORN_W: case DRAGON_W:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/*
+ The candidate moves are matched against the notation by building the AST of their full notation
+ (i.e. what pretty_move<SHOW_PAWN | SHOW_CAPTURE | SHOW_PROMOTION> prints) directly.
+ Candidates are filtered by piece name, source square and destination square beforehand.
+ */
 state::parse_pgn_res state::parse_move(const pgnparser_ast::move &move) const
 {
     std::vector<full_move> matched;
@@ -692,32 +918,63 @@ state::parse_pgn_res state::parse_move(const pgnparser_ast::move &move) const
     std::optional<full_move> fm;
     std::optional<piece_t> promotion;
     dprint("parse_move(",move,")");
-    constexpr static uint16_t FLAGS = SHOW_PAWN | SHOW_CAPTURE | SHOW_PROMOTION;
+    const int last_rank = player ? 0 : (m->get_board_size().second - 1);
+    // the promotion part of the full notation of a move of piece `pic` to `q`
+    auto full_promotion = [last_rank](char pic, vec4 q, std::optional<char> promote_to) -> std::optional<char> {
+        if(pic == PAWN_W && q.y() == last_rank)
+        {
+            return promote_to.value_or(static_cast<char>(QUEEN_W));
+        }
+        return std::nullopt;
+    };
+    // whether the notation can refer to a move from `p` of piece `pic`
+    auto source_filter = [](const auto &mv, vec4 p, char pic) {
+        return (!mv.piece_name || *mv.piece_name == pic)
+            && (!mv.from_file || *mv.from_file == p.x() + 'a')
+            && (!mv.from_rank || *mv.from_rank == p.y() + 1);
+    };
+    // the squares the notation can move to
+    auto destination_mask = [](char to_file, char to_rank) -> bitboard_t {
+        int x = to_file - 'a', y = to_rank - 1;
+        if(x < 0 || x >= BOARD_LENGTH || y < 0 || y >= BOARD_LENGTH)
+            return 0;
+        return pmask(ppos(x, y));
+    };
     if(std::holds_alternative<pgnparser_ast::physical_move>(move.data))
     {
-        auto mv = std::get<pgnparser_ast::physical_move>(move.data);
+        const auto &mv = std::get<pgnparser_ast::physical_move>(move.data);
+        bool castle = mv.castle == pgnparser_ast::CASTLE_KINGSIDE || mv.castle == pgnparser_ast::CASTLE_QUEENSIDE;
+        bitboard_t dst = castle ? ~bitboard_t(0) : destination_mask(mv.to_file, mv.to_rank);
+        // no move promotes to an illegal piece
+        if(mv.promote_to && !is_promotion_piece(*mv.promote_to))
+            dst = 0;
         // for all physical moves avilable in current state
         for(vec4 p : gen_movable_pieces())
         {
-            char piece = to_white(piece_name(get_piece(p, player)));
-            bitboard_t bb = player ? m->gen_physical_moves<true>(p) : m->gen_physical_moves<false>(p);
+            char pic = to_white(piece_name(get_piece(p, player)));
+            if(!castle && !source_filter(mv, p, pic))
+                continue;
+            if(mv.board && !pgnparser::match_absolute_board(*mv.board, board_ast(*m, p.tl())))
+                continue;
+            bitboard_t bb = dst & (player ? m->gen_physical_moves<true>(p) : m->gen_physical_moves<false>(p));
             for(int pos : marked_pos(bb))
             {
                 vec4 q(pos, p.tl());
-                full_move fm(p,q);
-                dprint("matching", fm);
-                // test if this physical move matches any of them
-                std::string full_notation = pretty_move<FLAGS>(fm);
-                auto full = pgnparser(full_notation).parse_physical_move();
-                assert(full.has_value());
-                bool match = pgnparser::match_physical_move(mv, *full);
-                if(match)
+                dprint("matching", full_move(p,q));
+                pgnparser_ast::physical_move full{
+                    board_ast(*m, p.tl()), pgnparser_ast::NIL, pic,
+                    static_cast<char>(p.x() + 'a'), static_cast<char>(p.y() + 1),
+                    get_piece(q, player) != NO_PIECE,
+                    static_cast<char>(q.x() + 'a'), static_cast<char>(q.y() + 1),
+                    full_promotion(pic, q, mv.promote_to)
+                };
+                if(pgnparser::match_physical_move(mv, full))
                 {
                     dprint("matched");
-                    matched.push_back(fm);
-                    if(piece == PAWN_W)
+                    matched.push_back(full_move(p,q));
+                    if(pic == PAWN_W)
                     {
-                        pawn_move_matched.push_back(fm);
+                        pawn_move_matched.push_back(full_move(p,q));
                     }
                 }
             }
@@ -744,34 +1001,52 @@ state::parse_pgn_res state::parse_move(const pgnparser_ast::move &move) const
     else if(std::holds_alternative<pgnparser_ast::superphysical_move>(move.data))
     {
         // do the same for superphysical moves
-        auto spm = std::get<pgnparser_ast::superphysical_move>(move.data);
+        const auto &spm = std::get<pgnparser_ast::superphysical_move>(move.data);
+        bitboard_t dst = destination_mask(spm.to_file, spm.to_rank);
+        // the full notation always gives the destination board as an absolute board
+        bool to_board_ok = !std::holds_alternative<pgnparser_ast::relative_board>(spm.to_board);
+        if(spm.promote_to && !is_promotion_piece(*spm.promote_to))
+            to_board_ok = false;
         for(vec4 p : gen_movable_pieces())
         {
-            char piece = to_white(piece_name(get_piece(p, player)));
-            auto gen = player ? m->gen_superphysical_moves<true>(p) : m->gen_superphysical_moves<false>(p);
-            for(const auto& [p0, bb] : gen)
-            {
-                for(int pos : marked_pos(bb))
+            if(!to_board_ok)
+                break;
+            char pic = to_white(piece_name(get_piece(p, player)));
+            if(!source_filter(spm, p, pic))
+                continue;
+            if(spm.from_board && !pgnparser::match_absolute_board(*spm.from_board, board_ast(*m, p.tl())))
+                continue;
+            auto match = [&](vec4 p0, bitboard_t bb) {
+                for(int pos : marked_pos(bb & dst))
                 {
                     vec4 q(pos, p0);
-                    full_move fm(p,q);
-                    dprint("matching", fm);
-                    // test if this physical move matches any of them
-                    std::string full_notation = pretty_move<FLAGS>(fm);
-                    auto full = pgnparser(full_notation).parse_superphysical_move();
-                    assert(full.has_value());
-                    bool match = pgnparser::match_superphysical_move(spm, *full);
-                    if(match)
+                    dprint("matching", full_move(p,q));
+                    bool branching = std::pair{q.t(), player} < get_timeline_end(q.l());
+                    pgnparser_ast::superphysical_move full{
+                        board_ast(*m, p.tl()), pic,
+                        static_cast<char>(p.x() + 'a'), static_cast<char>(p.y() + 1),
+                        branching ? pgnparser_ast::BRANCHING_JUMP : pgnparser_ast::NON_BRANCH_JUMP,
+                        get_piece(q, player) != NO_PIECE,
+                        board_ast(*m, q.tl()),
+                        static_cast<char>(q.x() + 'a'), static_cast<char>(q.y() + 1),
+                        full_promotion(pic, q, spm.promote_to)
+                    };
+                    if(pgnparser::match_superphysical_move(spm, full))
                     {
                         dprint("matched");
-                        matched.push_back(fm);
-                        if(piece == PAWN_W)
+                        matched.push_back(full_move(p,q));
+                        if(pic == PAWN_W)
                         {
-                            pawn_move_matched.push_back(fm);
+                            pawn_move_matched.push_back(full_move(p,q));
                         }
                     }
                 }
-            }
+                return false;
+            };
+            if(player)
+                m->visit_superphysical_moves<true>(p, match);
+            else
+                m->visit_superphysical_moves<false>(p, match);
         }
         if(matched.size()==1)
         {
@@ -806,7 +1081,9 @@ template bool state::apply_move<true>(full_move, piece_t);
 template bool state::submit<false>();
 template bool state::submit<true>();
 
-template generator<full_move> state::find_checks_impl<false>(std::vector<int>) const;
-template generator<full_move> state::find_checks_impl<true>(std::vector<int>) const;
+template bool state::visit_checks_impl<false, false>(const std::vector<int>&, fn_ref<bool(full_move)>) const;
+template bool state::visit_checks_impl<true, false>(const std::vector<int>&, fn_ref<bool(full_move)>) const;
+template bool state::visit_checks_impl<false, true>(const std::vector<int>&, fn_ref<bool(full_move)>) const;
+template bool state::visit_checks_impl<true, true>(const std::vector<int>&, fn_ref<bool(full_move)>) const;
 template std::vector<vec4> state::gen_movable_pieces_impl<false>(std::vector<int>) const;
 template std::vector<vec4> state::gen_movable_pieces_impl<true>(std::vector<int>) const;
@@ -21,24 +21,45 @@ class state
     */
     int present;
     bool player;
+
+    /*
+     An entry of the undo stack: what make_move() or make_action() changed, i.e. the timelines that
+     received a board (in order) and the previous `present` and `player`.
+     */
+    struct undo_entry
+    {
+        std::vector<int> lines;
+        int present;
+        bool player;
+        bool is_action;
+    };
+    std::vector<undo_entry> undo_stack;
+    // timelines receiving a board when `fm` is applied, see apply_move()
+    std::vector<int> touched_lines(full_move fm) const;
+    void undo(const undo_entry &e);
     
     template<bool C>
     std::vector<vec4> gen_movable_pieces_impl(std::vector<int> lines) const;
     
     /*
-     find_check_impl<C>(lines)
+     visit_checks_impl<C, ONLY_SP>(lines, f)
      For all boards on the end of timelines specified in `lines` with color `C`,
-     test if one of piece on that board with color `C` can capture an enermy royal piece.
+     call `f` on each move of a piece on that board with color `C` capturing an enermy royal piece.
+     If `ONLY_SP` is set, only moves leaving the board are generated.
      */
-    template<bool C>
-    generator<full_move> find_checks_impl(std::vector<int> lines) const;
+    template<bool C, bool ONLY_SP = false>
+    bool visit_checks_impl(const std::vector<int> &lines, fn_ref<bool(full_move)> f) const;
+    // timelines whose last board has color `c`, i.e. where pieces of `c` can give check
+    std::vector<int> check_source_lines(bool c) const;
+
+    state(std::unique_ptr<multiverse> mtv, int present, bool player) noexcept;
 
 public:
     state(multiverse &mtv) noexcept;
     state(const pgnparser_ast::game &g);
     virtual ~state() = default;
     
-    // standard copy-constructors
+    // standard copy-constructors; the undo history is not copied
     state(const state& other)
     : m{other.m->clone()}, present{other.present}, player{other.player} {}
     state(state&&) noexcept = default;
@@ -50,8 +71,23 @@ public:
         std::swap(a.m, b.m);
         std::swap(a.present, b.present);
         std::swap(a.player, b.player);
+        std::swap(a.undo_stack, b.undo_stack);
     }
 
+    /*
+     hash(): hash of the multiverse folded with `present` and `player`.
+     Equal states always have equal hashes; operator== only walks the boards when the hashes agree.
+     */
+    uint64_t hash() const;
+    bool operator==(const state& other) const;
+
+    /*
+     serialize(): binary image of the state, i.e. `present`, `player` and multiverse::serialize().
+     deserialize(data): the inverse; throws std::runtime_error on malformed data.
+     */
+    std::string serialize() const;
+    static state deserialize(std::string_view data);
+
 
     /*
      can_apply: Check if the move can be applied to the current state. If yes, return the new state after applying the move; otherwise return std::nullopt.
@@ -69,6 +105,21 @@ public:
     bool apply_move(full_move fm, piece_t promote_to = QUEEN_W);
     template<bool UNSAFE = false>
     bool submit();
+
+    /*
+     make_move(fm, promote_to): apply_move() recording the change on the undo stack; nothing is
+     recorded if the move is rejected.
+     make_action(act): apply all moves of `act` and submit, recorded as a single entry. If any
+     step fails, the moves already made are undone and false is returned.
+     unmake_move() / unmake_action(): revert the latest entry, which must have been made by
+     make_move() / make_action() respectively. Boards are popped instead of copying the state,
+     so both directions cost O(moves).
+     */
+    bool make_move(full_move fm, piece_t promote_to = QUEEN_W);
+    void unmake_move();
+    bool make_action(const action &act);
+    void unmake_action();
+    size_t undo_depth() const;
     
     /*
      phantom: state used for deciding whether the current is a checkmate or stalemate
@@ -92,8 +143,24 @@ public:
     
     /*
      find_checks(): Test if that player with color `c` is able to capture an enermy royal piece.
+     visit_checks(c, f) calls `f` on each such capture until it returns true, and first_check(c)
+     returns the first one; both avoid the coroutine of find_checks().
      */
     generator<full_move> find_checks(bool c) const;
+    bool visit_checks(bool c, fn_ref<bool(full_move)> f) const;
+    std::optional<full_move> first_check(bool c) const;
+    /*
+     first_superphysical_check(c): first_check(c) restricted to moves leaving their board.
+     It is meant for callers that have already excluded physical checks, e.g. by testing each new
+     board once (see HC_info::build_HC()); the physical move generation is skipped entirely.
+     */
+    std::optional<full_move> first_superphysical_check(bool c) const;
+    /*
+     first_check_from_royals(c): same test as first_check(c), but done backwards: it looks for
+     attackers (see multiverse::attackers_of()) of every enemy royal piece on the boards of color `c`.
+     It returns some check if there is one, not necessarily the one first_check(c) returns.
+     */
+    std::optional<full_move> first_check_from_royals(bool c) const;
     
     std::vector<vec4> gen_movable_pieces() const;
     std::vector<vec4> get_movable_pieces(std::vector<int> lines) const;
@@ -129,9 +196,14 @@ public:
     turn_t get_timeline_end(int l) const;
     piece_t get_piece(vec4 p, bool color) const;
     std::shared_ptr<board> get_board(int l, int t, bool c) const;
+    const board *get_board_ptr(int l, int t, bool c) const noexcept;
     std::vector<std::tuple<int,int,bool,std::string>> get_boards() const;
     generator<vec4> gen_piece_move(vec4 p) const;
     generator<vec4> gen_piece_move(vec4 p, bool c) const;
+    bool visit_piece_move(vec4 p, fn_ref<bool(vec4)> f) const;
+    std::vector<vec4> attackers_of(vec4 q, bool c) const;
+    // whether `fm` is a pseudolegal move of the current player, see multiverse::is_pseudolegal()
+    bool is_pseudolegal(full_move fm) const;
     std::string to_string() const;
     std::string show_fen() const;
     
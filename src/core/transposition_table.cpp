@@ -0,0 +1,199 @@
+#include "transposition_table.h"
+#include <algorithm>
+#include <iterator>
+#include "hypercuboid.h"
+
+transposition_table::transposition_table(size_t budget_bytes, policy p, size_t num_shards)
+: budget(budget_bytes), replacement(p), shards(std::max<size_t>(num_shards, 1)), hits(0), misses(0)
+{}
+
+transposition_table::shard &transposition_table::shard_of(uint64_t key)
+{
+    // the low bits are used by the hash maps inside shards
+    return shards[(key >> 48) % shards.size()];
+}
+
+size_t transposition_table::node_bytes(const shard::node_t &node)
+{
+    const entry &e = node.e;
+    // list node + hash map node + payload
+    size_t bytes = sizeof(shard::node_t) + 2 * sizeof(void*)
+                 + sizeof(std::pair<uint64_t, std::list<shard::node_t>::iterator>) + 2 * sizeof(void*)
+                 + node.image.capacity();
+    if(e.first_action)
+    {
+        bytes += e.first_action->get_moves().size() * sizeof(ext_move);
+    }
+    if(e.actions)
+    {
+        bytes += e.actions->capacity() * sizeof(action);
+        for(const action &act : *e.actions)
+        {
+            bytes += act.get_moves().size() * sizeof(ext_move);
+        }
+    }
+    return bytes;
+}
+
+void transposition_table::evict(shard &sh, size_t shard_budget)
+{
+    while(sh.bytes > shard_budget && !sh.order.empty())
+    {
+        const shard::node_t &node = sh.order.back();
+        sh.bytes -= node_bytes(node);
+        sh.index.erase(node.key);
+        sh.order.pop_back();
+    }
+}
+
+std::optional<transposition_table::entry> transposition_table::lookup(uint64_t key, std::string_view image)
+{
+    shard &sh = shard_of(key);
+    std::lock_guard<std::mutex> lock(sh.mtx);
+    auto it = sh.index.find(key);
+    if(it == sh.index.end() || it->second->image != image)
+    {
+        misses++;
+        return std::nullopt;
+    }
+    hits++;
+    if(replacement == policy::LRU)
+    {
+        sh.order.splice(sh.order.begin(), sh.order, it->second);
+    }
+    return it->second->e;
+}
+
+void transposition_table::store(uint64_t key, std::string image, entry e)
+{
+    size_t shard_budget = budget / shards.size();
+    shard::node_t node{key, std::move(image), std::move(e)};
+    size_t bytes = node_bytes(node);
+    if(bytes > shard_budget)
+        return;
+    shard &sh = shard_of(key);
+    std::lock_guard<std::mutex> lock(sh.mtx);
+    auto it = sh.index.find(key);
+    if(it != sh.index.end())
+    {
+        // also replaces a colliding state
+        sh.bytes -= node_bytes(*it->second);
+        sh.order.erase(it->second);
+        sh.index.erase(it);
+    }
+    sh.order.push_front(std::move(node));
+    sh.index.emplace(key, sh.order.begin());
+    sh.bytes += bytes;
+    evict(sh, shard_budget);
+}
+
+void transposition_table::clear()
+{
+    for(shard &sh : shards)
+    {
+        std::lock_guard<std::mutex> lock(sh.mtx);
+        sh.order.clear();
+        sh.index.clear();
+        sh.bytes = 0;
+    }
+    hits = 0;
+    misses = 0;
+}
+
+transposition_table::entry transposition_table::query(const state &s, bool all_actions)
+{
+    uint64_t key = s.hash();
+    std::string image = s.serialize();
+    std::optional<entry> cached = lookup(key, image);
+    if(cached && (!all_actions || cached->actions || cached->status != match_status_t::PLAYING))
+    {
+        if(all_actions && !cached->actions)
+        {
+            cached->actions.emplace();
+        }
+        return *cached;
+    }
+    entry e = compute(s, all_actions);
+    store(key, std::move(image), e);
+    return e;
+}
+
+transposition_table::entry transposition_table::compute(const state &s, bool all_actions)
+{
+    entry e;
+    std::vector<action> actions;
+    auto [w, ss] = HC_info::build_HC(s);
+    for(moveseq mvs : w.search(ss))
+    {
+        std::vector<ext_move> emvs;
+        std::transform(mvs.begin(), mvs.end(), std::back_inserter(emvs), [](full_move m){
+            return ext_move(m);
+        });
+        action act = action::from_vector(emvs, s);
+        if(!e.first_action)
+        {
+            e.first_action = act;
+        }
+        if(!all_actions)
+            break;
+        actions.push_back(std::move(act));
+    }
+    if(all_actions)
+    {
+        e.actions = std::move(actions);
+    }
+    if(e.first_action)
+    {
+        e.status = match_status_t::PLAYING;
+    }
+    else
+    {
+        auto [t, c] = s.get_present();
+        if(s.phantom().first_check(!c).has_value())
+        {
+            e.status = c ? match_status_t::WHITE_WINS : match_status_t::BLACK_WINS;
+        }
+        else
+        {
+            e.status = match_status_t::STALEMATE;
+        }
+    }
+    return e;
+}
+
+size_t transposition_table::size() const
+{
+    size_t n = 0;
+    for(const shard &sh : shards)
+    {
+        std::lock_guard<std::mutex> lock(sh.mtx);
+        n += sh.index.size();
+    }
+    return n;
+}
+
+size_t transposition_table::memory_usage() const
+{
+    size_t bytes = 0;
+    for(const shard &sh : shards)
+    {
+        std::lock_guard<std::mutex> lock(sh.mtx);
+        bytes += sh.bytes;
+    }
+    return bytes;
+}
+
+size_t transposition_table::get_budget() const
+{
+    return budget;
+}
+
+size_t transposition_table::get_hits() const
+{
+    return hits;
+}
+
+size_t transposition_table::get_misses() const
+{
+    return misses;
+}
@@ -0,0 +1,90 @@
+// transposition_table.h
+// memoization of legal action search results, keyed by state::hash() and verified against the state
+
+#ifndef TRANSPOSITION_TABLE_H
+#define TRANSPOSITION_TABLE_H
+
+#include <vector>
+#include <string>
+#include <string_view>
+#include <list>
+#include <unordered_map>
+#include <optional>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include "state.h"
+#include "action.h"
+#include "turn.h"
+
+/*
+ A bounded, thread-safe transposition table.
+
+ The table is split into shards, each protected by its own mutex and owning an equal share of
+ the memory budget. When a shard goes over budget, entries are evicted according to the
+ replacement policy:
+ - LRU: evict the least recently used entry (lookups refresh an entry)
+ - FIFO: evict the oldest inserted entry (lookups do not reorder)
+
+ Entries are found by the 64-bit state hash and verified against the state::serialize() image
+ stored with them, so a hash collision is a miss rather than a wrong result.
+ */
+class transposition_table
+{
+public:
+    enum class policy {LRU, FIFO};
+    struct entry
+    {
+        match_status_t status;
+        std::optional<action> first_action; // has value iff status == PLAYING
+        std::optional<std::vector<action>> actions; // the full list of legal actions, if it was computed
+    };
+    constexpr static size_t DEFAULT_BUDGET = 64 << 20; // 64 MiB
+
+private:
+    struct shard
+    {
+        struct node_t
+        {
+            uint64_t key;
+            std::string image;
+            entry e;
+        };
+        mutable std::mutex mtx;
+        std::list<node_t> order; // front is the next one to keep, back is the next one to evict
+        std::unordered_map<uint64_t, std::list<node_t>::iterator> index;
+        size_t bytes = 0;
+    };
+    const size_t budget;
+    const policy replacement;
+    std::vector<shard> shards;
+    std::atomic<size_t> hits, misses;
+
+    shard &shard_of(uint64_t key);
+    static size_t node_bytes(const shard::node_t &node);
+    void evict(shard &sh, size_t shard_budget);
+
+public:
+    transposition_table(size_t budget_bytes = DEFAULT_BUDGET, policy p = policy::LRU, size_t num_shards = 16);
+
+    // `key` is the hash of the state and `image` its serialization
+    std::optional<entry> lookup(uint64_t key, std::string_view image);
+    void store(uint64_t key, std::string image, entry e);
+    void clear();
+
+    /*
+     query(s, all_actions):
+     Return the cached entry of `s` if there is one (and it contains the full list of actions
+     when `all_actions` is set). Otherwise run the hypercuboid search on `s`, store and return the result.
+     */
+    entry query(const state &s, bool all_actions = false);
+    static entry compute(const state &s, bool all_actions = false);
+
+    size_t size() const;
+    size_t memory_usage() const;
+    size_t get_budget() const;
+    size_t get_hits() const;
+    size_t get_misses() const;
+};
+
+#endif /* TRANSPOSITION_TABLE_H */
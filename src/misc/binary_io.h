@@ -0,0 +1,52 @@
+// binary_io.h
+// helpers for fixed-layout binary images in native byte order
+
+#ifndef BINARY_IO_H
+#define BINARY_IO_H
+
+#include <string>
+#include <string_view>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+
+// appends trivially copyable values to a byte string
+struct binary_writer
+{
+    std::string &out;
+    template<typename T>
+    void put(const T &x)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        out.append(reinterpret_cast<const char*>(&x), sizeof(T));
+    }
+};
+
+// reads values back; throws std::runtime_error instead of reading past the end
+struct binary_reader
+{
+    std::string_view in;
+    size_t pos = 0;
+    const char *take(size_t n)
+    {
+        if(n > in.size() - pos)
+            throw std::runtime_error("binary_reader: Truncated data");
+        const char *p = in.data() + pos;
+        pos += n;
+        return p;
+    }
+    template<typename T>
+    T get()
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        T x;
+        std::memcpy(&x, take(sizeof(T)), sizeof(T));
+        return x;
+    }
+    size_t remaining() const
+    {
+        return in.size() - pos;
+    }
+};
+
+#endif /* BINARY_IO_H */
@@ -0,0 +1,42 @@
+#ifndef FN_REF_H
+#define FN_REF_H
+
+#include <type_traits>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <concepts>
+
+/*
+ fn_ref<R(Args...)>: a non-owning reference to a callable object.
+
+ Unlike std::function it never allocates and costs one indirect call. It is meant to be used
+ as a parameter type for callbacks (e.g. the move visitors); the referenced callable must
+ outlive the fn_ref, which holds whenever a lambda is passed directly as the argument.
+ */
+template<typename Sig>
+class fn_ref;
+
+template<typename R, typename ...Args>
+class fn_ref<R(Args...)>
+{
+    void *obj;
+    R (*call)(void*, Args...);
+
+public:
+    template<typename F>
+        requires (!std::same_as<std::remove_cvref_t<F>, fn_ref> && std::is_invocable_r_v<R, F&, Args...>)
+    fn_ref(F &&f) noexcept
+    : obj(const_cast<void*>(static_cast<const void*>(std::addressof(f))))
+    , call([](void *o, Args... args) -> R {
+        return std::invoke(*static_cast<std::remove_reference_t<F>*>(o), std::forward<Args>(args)...);
+    })
+    {}
+
+    R operator()(Args... args) const
+    {
+        return call(obj, std::forward<Args>(args)...);
+    }
+};
+
+#endif /* FN_REF_H */
@@ -0,0 +1,69 @@
+#include "mapped_file.h"
+#include <stdexcept>
+#include <fstream>
+#include <sstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define MAPPED_FILE_MMAP
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+mapped_file::mapped_file(const std::string &path) : data(nullptr), length(0), fallback{}
+{
+#ifdef MAPPED_FILE_MMAP
+    int fd = open(path.c_str(), O_RDONLY);
+    if(fd < 0)
+        throw std::runtime_error("mapped_file(): cannot open " + path);
+    struct stat st;
+    if(fstat(fd, &st) < 0)
+    {
+        close(fd);
+        throw std::runtime_error("mapped_file(): cannot stat " + path);
+    }
+    length = static_cast<size_t>(st.st_size);
+    if(length > 0)
+    {
+        void *p = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(p == MAP_FAILED)
+        {
+            close(fd);
+            throw std::runtime_error("mapped_file(): cannot map " + path);
+        }
+        // the file is read front to back
+        madvise(p, length, MADV_SEQUENTIAL);
+        data = static_cast<const char*>(p);
+    }
+    // the mapping stays valid after the descriptor is closed
+    close(fd);
+#else
+    std::ifstream in(path, std::ios::binary);
+    if(!in)
+        throw std::runtime_error("mapped_file(): cannot open " + path);
+    std::ostringstream oss;
+    oss << in.rdbuf();
+    fallback = oss.str();
+    data = fallback.data();
+    length = fallback.size();
+#endif
+}
+
+mapped_file::~mapped_file()
+{
+#ifdef MAPPED_FILE_MMAP
+    if(data)
+        munmap(const_cast<char*>(data), length);
+#endif
+}
+
+std::string_view mapped_file::view() const
+{
+    return std::string_view(data ? data : "", length);
+}
+
+size_t mapped_file::size() const
+{
+    return length;
+}
@@ -0,0 +1,31 @@
+// mapped_file.h
+// read-only view of a whole file, memory-mapped where the platform supports it
+
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <string>
+#include <string_view>
+
+/*
+ A read-only file mapped into memory. On POSIX systems the file is mmap'd, so opening a large
+ file costs nothing until its pages are touched; elsewhere the file is read into a buffer.
+ view() stays valid as long as the mapped_file object is alive. Throws std::runtime_error if the
+ file cannot be opened.
+ */
+class mapped_file
+{
+    const char *data;
+    size_t length;
+    std::string fallback; // owns the contents when the file is not mmap'd
+public:
+    explicit mapped_file(const std::string &path);
+    ~mapped_file();
+    mapped_file(const mapped_file&) = delete;
+    mapped_file &operator=(const mapped_file&) = delete;
+
+    std::string_view view() const;
+    size_t size() const;
+};
+
+#endif /* MAPPED_FILE_H */
@@ -0,0 +1,160 @@
+// pool_allocator.h
+// fixed-size block allocator with thread-local free lists
+
+#ifndef POOL_ALLOCATOR_H
+#define POOL_ALLOCATOR_H
+
+#include <cstddef>
+#include <new>
+#include <mutex>
+#include <algorithm>
+
+namespace detail
+{
+/*
+ A pool of blocks of SIZE bytes aligned to ALIGN.
+ Every thread allocates from and frees to its own free list without locking. Blocks are carved
+ from chunks that are never returned to the system; when a thread exits, its free list is handed
+ over to a global list, from which other threads refill. A block may be freed by a thread other
+ than the one that allocated it.
+ */
+template<size_t SIZE, size_t ALIGN>
+class fixed_pool
+{
+    struct node
+    {
+        node *next;
+    };
+    constexpr static size_t align = std::max(ALIGN, alignof(node));
+    constexpr static size_t block_size = (std::max(SIZE, sizeof(node)) + align - 1) / align * align;
+    constexpr static size_t blocks_per_chunk = 256;
+
+    inline static std::mutex global_mtx;
+    inline static node *global_head = nullptr;
+
+    // trivially destructible, so they stay usable while other thread_locals are destroyed
+    inline static thread_local node *local_head = nullptr;
+    inline static thread_local bool exited = false;
+
+    struct thread_exit_guard
+    {
+        ~thread_exit_guard()
+        {
+            give_back(local_head);
+            local_head = nullptr;
+            exited = true;
+        }
+    };
+
+    static void give_back(node *head)
+    {
+        if(head == nullptr)
+            return;
+        node *tail = head;
+        while(tail->next)
+            tail = tail->next;
+        std::lock_guard<std::mutex> lock(global_mtx);
+        tail->next = global_head;
+        global_head = head;
+    }
+
+    static void register_thread_exit()
+    {
+        thread_local thread_exit_guard guard;
+        (void)guard;
+    }
+
+    static void refill()
+    {
+        register_thread_exit();
+        {
+            std::lock_guard<std::mutex> lock(global_mtx);
+            if(global_head)
+            {
+                local_head = global_head;
+                global_head = nullptr;
+                return;
+            }
+        }
+        char *chunk = static_cast<char*>(::operator new(block_size * blocks_per_chunk, std::align_val_t(align)));
+        for(size_t i = 0; i < blocks_per_chunk; i++)
+        {
+            node *n = reinterpret_cast<node*>(chunk + i * block_size);
+            n->next = local_head;
+            local_head = n;
+        }
+    }
+
+public:
+    static void *allocate()
+    {
+        if(exited)
+        {
+            return ::operator new(block_size, std::align_val_t(align));
+        }
+        if(local_head == nullptr)
+        {
+            refill();
+        }
+        node *n = local_head;
+        local_head = n->next;
+        return n;
+    }
+
+    static void deallocate(void *p) noexcept
+    {
+        node *n = static_cast<node*>(p);
+        if(exited)
+        {
+            n->next = nullptr;
+            give_back(n);
+            return;
+        }
+        if(local_head == nullptr)
+        {
+            register_thread_exit();
+        }
+        n->next = local_head;
+        local_head = n;
+    }
+};
+} /* namespace detail */
+
+/*
+ pool_allocator<T>: a stateless allocator serving single objects from detail::fixed_pool.
+ It is meant for std::allocate_shared, which allocates one block holding both the control
+ block and the object. Arrays fall back to the global operator new.
+ */
+template<typename T>
+struct pool_allocator
+{
+    using value_type = T;
+
+    pool_allocator() noexcept = default;
+    template<typename U>
+    pool_allocator(const pool_allocator<U>&) noexcept {}
+
+    T *allocate(size_t n)
+    {
+        if(n == 1)
+        {
+            return static_cast<T*>(detail::fixed_pool<sizeof(T), alignof(T)>::allocate());
+        }
+        return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(alignof(T))));
+    }
+
+    void deallocate(T *p, size_t n) noexcept
+    {
+        if(n == 1)
+        {
+            detail::fixed_pool<sizeof(T), alignof(T)>::deallocate(p);
+            return;
+        }
+        ::operator delete(p, std::align_val_t(alignof(T)));
+    }
+
+    template<typename U>
+    bool operator==(const pool_allocator<U>&) const noexcept { return true; }
+};
+
+#endif /* POOL_ALLOCATOR_H */
@@ -9,6 +9,7 @@
 #include <algorithm>
 #include <iterator>
 #include <optional>
+#include <cstdint>
 
 /*
 The append/concatenate functions.
@@ -118,6 +119,18 @@ constexpr auto generate_array(std::index_sequence<N...>, F f)
     return {f(N)...};
 }
 
+/*
+ splitmix64 finalizer, used for generating hash keys and mixing hash values
+ See: https://prng.di.unimi.it/splitmix64.c
+ */
+constexpr uint64_t splitmix64(uint64_t x)
+{
+    x += 0x9e3779b97f4a7c15;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111eb;
+    return x ^ (x >> 31);
+}
+
 /*
  set minus function
  */
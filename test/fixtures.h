@@ -0,0 +1,111 @@
+// fixtures.h
+// positions shared by the tests
+
+#ifndef FIXTURES_H
+#define FIXTURES_H
+
+#include <string>
+#include <vector>
+#include <optional>
+#include <algorithm>
+#include <cassert>
+#include "game.h"
+#include "hypercuboid.h"
+
+// a 4x4 game branching into two timelines
+inline const std::string very_small_open =
+R"(
+[Size "4x4"]
+[Board "custom"]
+[Mode "5D"]
+[nbrk/3p*/P*3/KRBN:0:1:w]
+
+1. (0T1)Rb1xb4 / (0T1)Rc4xb4 
+2. (0T2)Bc1>>(0T1)c2 / (1T1)d3d2 
+3. (1T2)a2a3
+)";
+
+// unicorns and kings on a 5x5 board
+inline const std::string just_unicorns =
+R"(
+[Board "Custom - Odd"]
+[Mode "5D"]
+[Size "5x5"]
+[1u1uk*/5/5/5/K*U1U1:0:1:w]
+
+1. Kb2 / Kd4
+)";
+
+// all fairy pieces on two 6x6 timelines
+inline const std::string fairy_pieces =
+R"(
+[Mode "5D"]
+[Board "Custom - Even"]
+[Size "6x6"]
+[r*sdyck*/w*p*p*p*p*u/6/6/P*P*W*P*P*P*/R*SUDCK*:+0:1:w]
+[r*sdyck*/w*p*p*p*p*u/6/6/P*P*W*P*P*P*/R*SUDCK*:-0:1:w]
+)";
+
+// a standard game with a branching timeline
+inline const std::string standard_branching =
+R"(
+[Mode "5D"]
+[Board "Standard"]
+1.(0T1)Ng1f3 / (0T1)c7c6 
+2.(0T2)Nf3e5 / (0T2)Ng8>>(0T1)g6 
+3.(-1T2)d2d3 / (-1T2)Nb8c6 
+4.(-1T3)h2h4 (0T3)Ne5d7 / (0T3)Ke8d7 (-1T3)d7d5 
+5.(0T4)h2h3 (-1T4)Bc1f4 / (0T4)Qd8a5 (-1T4)Ng6f4 
+6.(0T5)Qd1>>(-1T4)d2 / (1T4)Qd8>>(-1T4)b6 
+)";
+
+// a "Standard - Turn Zero" game with time travel
+inline const std::string turn_zero =
+R"(
+[Mode "5D"]
+[Board "Standard - Turn Zero"]
+[Size "8x8"]
+
+1. Nf3 / (0T1)Ng8>>(0T0)g6
+2. (-1T1)Nf3
+)";
+
+/*
+ the current position of the game `pgn` and the ones following it, up to `plies` positions;
+ actions with time travel are taken when possible, so that more timelines are created
+ */
+inline std::vector<state> following_positions(const std::string &pgn, int plies)
+{
+    std::vector<state> positions;
+    state s = game::from_pgn(pgn).get_current_state();
+    for(int i = 0; i < plies; i++)
+    {
+        positions.push_back(s);
+        auto [w, ss] = HC_info::build_HC(s);
+        std::optional<moveseq> chosen;
+        int count = 0;
+        for(const moveseq &mvs : w.search(ss))
+        {
+            if(!chosen || std::any_of(mvs.begin(), mvs.end(), [](full_move m) {
+                return m.from.tl() != m.to.tl();
+            }))
+            {
+                chosen = mvs;
+            }
+            if(++count >= 50)
+                break;
+        }
+        if(!chosen)
+            break;
+        [[maybe_unused]] bool flag = true;
+        for(full_move m : *chosen)
+        {
+            flag = flag && s.apply_move<false>(m);
+        }
+        flag = flag && s.submit();
+        assert(flag);
+    }
+    return positions;
+}
+
+#endif /* FIXTURES_H */
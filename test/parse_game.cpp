@@ -1,5 +1,6 @@
 #include <iostream>
 #include <vector>
+#include <cassert>
 #include "pgnparser.h"
 #include "utils.h"
 #include "state.h"
@@ -64,11 +65,44 @@ void test_game()
     std::cout << s.to_string();
 }
 
+void test_parse_move()
+{
+    std::string str = R"(
+[Size "4x4"]
+[Board "Custom"]
+[Mode "5D"]
+[3k/P3/4/K3:0:1:w]
+)";
+    state s(*pgnparser(str).parse_game());
+    full_move promote(vec4(0,2,1,0), vec4(0,3,1,0));
+    auto [fm, pt, candidates] = s.parse_move("a4");
+    assert(fm == promote && !pt && candidates.size() == 1);
+    std::tie(fm, pt, candidates) = s.parse_move("(0T1)Pa3a4=N");
+    assert(fm == promote && pt == KNIGHT_W);
+    // only pieces a pawn can promote to
+    for(const char *illegal : {"a4=K", "a4=P", "a4=Y", "a4=C", "(0T1)Pa3a4=K"})
+    {
+        assert(!std::get<0>(s.parse_move(illegal)));
+    }
+    for(const char *legal : {"a4=Q", "a4=R", "a4=B", "a4=S", "a4=U", "a4=D"})
+    {
+        assert(std::get<0>(s.parse_move(legal)) == promote);
+    }
+    std::tie(fm, pt, candidates) = s.parse_move("Ka2");
+    assert(fm == full_move(vec4(0,0,1,0), vec4(0,1,1,0)));
+    // wrong board, piece or source square
+    assert(!std::get<0>(s.parse_move("(1T1)a4")));
+    assert(!std::get<0>(s.parse_move("Na4")));
+    assert(!std::get<0>(s.parse_move("ba4")));
+    assert(!std::get<0>(s.parse_move("Ka3")));
+}
+
 int main()
 {
     //test_actions();
     //test_gametree();
     test_game();
+    test_parse_move();
     std::cout << "---= parse_game.cpp: all tests passed =---" <<std::endl;
     return 0;
 }
@@ -0,0 +1,127 @@
+#include <iostream>
+#include <cassert>
+#include <set>
+#include <map>
+#include "game.h"
+#include "hypercuboid.h"
+#include "fixtures.h"
+
+std::string exiled_kings =
+R"(
+[Mode "5D"]
+[Board "Standard - Turn Zero"]
+1.(0T1)Ng1f3 / (0T1)e7e6
+2.(0T2)b2b3 / (0T2)c7c6
+3.(0T3)e2e3 / (0T3)Qd8b6
+4.(0T4)Nf3g5 / (0T4)Qb6>>(0T0)f2
+5.(-1T1)Ke1f2 / (-1T1)Ng8f6
+6.(-1T2)e2e3 / (-1T2)Nf6>>(-1T1)f4
+7.(-1T3)Kf2e1 / (-1T3)Ke8>>(0T4)d8
+8.(-1T4)Qd1f3 / (-1T4)f7f6
+)";
+
+/*
+ compare attackers_of() against the moves generated forwards from every piece on the last boards,
+ for both colors and every square of every board
+ */
+int check_state(const state &s)
+{
+    auto [l_min, l_max] = s.get_lines_range();
+    auto [size_x, size_y] = s.get_board_size();
+    int tested = 0;
+    for(bool c : {false, true})
+    {
+        std::map<vec4, std::set<vec4>> expected;
+        for(int l = l_min; l <= l_max; l++)
+        {
+            auto [t, c1] = s.get_timeline_end(l);
+            if(c1 != c)
+                continue;
+            const board *b_ptr = s.get_board_ptr(l, t, c);
+            bitboard_t pieces = (c ? b_ptr->friendly<true>() : b_ptr->friendly<false>()) & ~b_ptr->wall();
+            for(int pos : marked_pos(pieces))
+            {
+                vec4 p(pos, vec4(0, 0, t, l));
+                for(vec4 q : s.gen_piece_move(p, c))
+                {
+                    expected[q].insert(p);
+                }
+            }
+        }
+        for(int l = l_min; l <= l_max; l++)
+        {
+            auto [t0, c0] = s.get_timeline_start(l);
+            auto [t1, c1] = s.get_timeline_end(l);
+            for(int t = t0; t <= t1; t++)
+            {
+                if(s.get_board_ptr(l, t, c) == nullptr)
+                    continue;
+                for(int y = 0; y < size_y; y++)
+                {
+                    for(int x = 0; x < size_x; x++)
+                    {
+                        vec4 q(x, y, t, l);
+                        std::vector<vec4> found = s.attackers_of(q, c);
+                        std::set<vec4> actual(found.begin(), found.end());
+                        if(actual.size() != found.size() || actual != expected[q])
+                        {
+                            std::cerr << "mismatch on " << q << " for color " << c << "\n" << s.to_string();
+                        }
+                        assert(actual.size() == found.size() && actual == expected[q]);
+                        tested += static_cast<int>(found.size());
+                    }
+                }
+            }
+        }
+        // the backward check test agrees with the forward one
+        assert(s.first_check(c).has_value() == s.first_check_from_royals(c).has_value());
+        if(auto fm = s.first_check_from_royals(c))
+        {
+            assert(s.get_board_ptr(fm->to.l(), fm->to.t(), c)->royal() & pmask(fm->to.xy()));
+        }
+    }
+    return tested;
+}
+
+// check a few positions following the game
+void check_game(const std::string &pgn, int plies)
+{
+    int tested = 0;
+    for(const state &s : following_positions(pgn, plies))
+    {
+        // the phantom state has the boards of the opponent on the ends, where checks are tested
+        tested += check_state(s) + check_state(s.phantom());
+    }
+    assert(tested > 0);
+}
+
+/*
+ positions where black checks white, physically and from another timeline
+ */
+void test_check()
+{
+    state s0 = game::from_pgn(very_small_open).get_current_state();
+    for(const char *mv : {"(1T2)b4c3", "(1T2)b4a3"})
+    {
+        state s = s0;
+        [[maybe_unused]] bool flag = s.apply_move(full_move(mv)) && s.apply_move(full_move("(0T2)d4c4")) && s.submit();
+        assert(flag);
+        state ph = s.phantom();
+        [[maybe_unused]] auto fm = ph.first_check_from_royals(true);
+        assert(fm.has_value() && ph.first_check(true).has_value());
+        assert(ph.get_board_ptr(fm->to.l(), fm->to.t(), true)->king() & pmask(fm->to.xy()));
+    }
+    std::cout << "test_check passed" << std::endl;
+}
+
+int main()
+{
+    check_game(very_small_open, 4);
+    check_game(just_unicorns, 4);
+    check_game(fairy_pieces, 6);
+    check_game(standard_branching, 2);
+    check_game(exiled_kings, 2);
+    test_check();
+    std::cout << "---= test_attackers.cpp: all passed =---" << std::endl;
+    return 0;
+}
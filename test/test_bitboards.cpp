@@ -179,6 +179,31 @@ void test_attacks()
     cerr << "test_attacks passed" << endl;
 }
 
+void test_slider_backends()
+{
+    std::mt19937_64 gen(2025);
+    std::uniform_int_distribution<uint64_t> dist(0, UINT64_MAX);
+    const slider_backend default_backend = get_slider_backend();
+    assert(slider_backend_supported(default_backend));
+    for(slider_backend backend : supported_slider_backends())
+    {
+        set_slider_backend(backend);
+        assert(get_slider_backend() == backend);
+        for(int i = 0; i < 100000; i++)
+        {
+            // dense and sparse blockers
+            uint64_t random_blocker = i % 2 ? dist(gen) : dist(gen) & dist(gen) & dist(gen);
+            int random_entry = i % 64;
+            ASSERT_EQ(rook_attack(random_entry, random_blocker), ratt(random_entry, random_blocker));
+            ASSERT_EQ(bishop_attack(random_entry, random_blocker), batt(random_entry, random_blocker));
+            ASSERT_EQ(queen_attack(random_entry, random_blocker), ratt(random_entry, random_blocker) | batt(random_entry, random_blocker));
+        }
+        cerr << slider_backend_name(backend) << " ";
+    }
+    set_slider_backend(default_backend);
+    cerr << "test_slider_backends passed" << endl;
+}
+
 //void test_bb_conversion()
 //{
 //    std::random_device rd;
@@ -197,6 +222,7 @@ void test_attacks()
  int main()
  {
      test_attacks();
+     test_slider_backends();
      //test_bb_conversion();
      cerr << "---= test_bitboards.cpp: all passed =---" << endl;
      return 0;
@@ -0,0 +1,67 @@
+#include <iostream>
+#include <cassert>
+#include "board_interner.h"
+#include "game.h"
+#include "fixtures.h"
+
+void test_intern_boards()
+{
+    board b("r*nbqk*bnr*/p*p*p*p*p*p*p*p*/8/8/8/8/P*P*P*P*P*P*P*P*/R*NBQK*BNR*");
+    // without an active interner, equal boards are distinct objects
+    auto c0 = b.replace_piece(ppos(1,0), NO_PIECE)->replace_piece(ppos(6,0), NO_PIECE);
+    auto d0 = b.replace_piece(ppos(6,0), NO_PIECE)->replace_piece(ppos(1,0), NO_PIECE);
+    assert(*c0 == *d0 && c0 != d0);
+
+    board_interner bi;
+    std::weak_ptr<board> w;
+    {
+        board_interner::scope guard(&bi);
+        auto c = b.replace_piece(ppos(1,0), NO_PIECE)->replace_piece(ppos(6,0), NO_PIECE);
+        auto d = b.replace_piece(ppos(6,0), NO_PIECE)->replace_piece(ppos(1,0), NO_PIECE);
+        assert(*c == *d && c == d);
+        assert(bi.get_hits() == 1);
+        {
+            // a nested null scope disables interning
+            board_interner::scope off(nullptr);
+            auto e = b.replace_piece(ppos(1,0), NO_PIECE)->replace_piece(ppos(6,0), NO_PIECE);
+            assert(e != c);
+        }
+        auto f = b.replace_pieces({{ppos(1,0), NO_PIECE}, {ppos(6,0), NO_PIECE}});
+        assert(f == c);
+        w = c;
+    }
+    // the interner does not keep boards alive
+    assert(w.expired() && bi.size() > 0);
+    {
+        board_interner::scope guard(&bi);
+        auto g = b.replace_piece(ppos(1,0), NO_PIECE)->replace_piece(ppos(6,0), NO_PIECE);
+        assert(*g == *c0);
+    }
+    bi.clear();
+    assert(bi.size() == 0 && bi.get_hits() == 0);
+}
+
+void test_game_interner()
+{
+    auto bi = std::make_shared<board_interner>();
+    game g = game::from_pgn(very_small_open, bi);
+    game h = game::from_pgn(very_small_open);
+    assert(g.get_board_interner() == bi && !h.get_board_interner());
+    assert(bi->size() > 0);
+    assert(g.show_pgn() == h.show_pgn());
+    assert(g.get_current_state() == h.get_current_state());
+    // replaying the game in a second game shares the boards of the first one
+    [[maybe_unused]] size_t hits = bi->get_hits();
+    game k = game::from_pgn(very_small_open, bi);
+    assert(bi->get_hits() > hits);
+    std::shared_ptr<board> b_ptr = g.get_current_state().get_board(0, 2, false);
+    assert(b_ptr && k.get_current_state().get_board(0, 2, false) == b_ptr);
+}
+
+int main()
+{
+    test_intern_boards();
+    test_game_interner();
+    std::cout << "---= test_board_interner.cpp: all passed =---" << std::endl;
+    return 0;
+}
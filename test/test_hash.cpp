@@ -0,0 +1,76 @@
+#include <iostream>
+#include <cassert>
+#include "state.h"
+#include "pgnparser.h"
+#include "fixtures.h"
+
+void test_board_hash()
+{
+    board b("r*nbqk*bnr*/p*p*p*p*p*p*p*p*/8/8/8/8/P*P*P*P*P*P*P*P*/R*NBQK*BNR*");
+    board c("r*nbqk*bnr*/p*p*p*p*p*p*p*p*/8/8/8/8/P*P*P*P*P*P*P*P*/R*NBQK*BNR*");
+    assert(b.hash() == c.hash() && b == c);
+    // removing and putting back a piece restores the hash
+    auto d = b.replace_piece(ppos(1,0), NO_PIECE);
+    assert(d->hash() != b.hash() && !(*d == b));
+    auto e = d->replace_piece(ppos(1,0), KNIGHT_W);
+    assert(e->hash() == b.hash() && *e == b);
+    // a moved piece loses its umove flag
+    auto f = b.move_piece(ppos(0,1), ppos(0,2))->move_piece(ppos(0,2), ppos(0,1));
+    assert(f->hash() != b.hash() && !(*f == b));
+    // same pieces on a different square
+    board g("8/8/8/8/8/8/8/K7"), h("8/8/8/8/8/8/8/1K6");
+    assert(g.hash() != h.hash());
+    std::cout << "test_board_hash passed" << std::endl;
+}
+
+void test_state_hash()
+{
+    state s(*pgnparser(very_small_open).parse_game());
+    state t(*pgnparser(very_small_open).parse_game());
+    assert(s.hash() == t.hash() && s == t);
+    
+    full_move fm0("(0T2)Rb4b1"), fm1("(1T2)Rc4c2");
+    state s0 = s, s1 = s;
+    bool flag = s0.apply_move(fm0) && s0.apply_move(fm1);
+    flag = flag && s1.apply_move(fm1) && s1.apply_move(fm0);
+    assert(flag);
+    // transposed move orders reach the same state
+    assert(s0.hash() == s1.hash() && s0 == s1);
+    assert(s0.hash() != s.hash() && !(s0 == s));
+    
+    // same boards but different player to move
+    auto u = s0.can_submit();
+    assert(u.has_value());
+    assert(u->hash() != s0.hash() && !(*u == s0));
+    std::cout << "test_state_hash passed" << std::endl;
+}
+
+void test_shared_timelines()
+{
+    state s(*pgnparser(very_small_open).parse_game());
+    state t(*pgnparser(very_small_open).parse_game());
+    state s0 = s;
+    [[maybe_unused]] bool flag = s0.apply_move(full_move("(0T2)Rb4b1"));
+    assert(flag);
+    // the copy is modified without touching the original
+    assert(s == t && !(s0 == s));
+    assert(s.get_board_ptr(0, 3, false) == nullptr && s0.get_board_ptr(0, 3, false) != nullptr);
+    // both copies still hold the same board objects where nothing changed
+    assert(s0.get_board_ptr(1, 2, true) == s.get_board_ptr(1, 2, true));
+    assert(s0.get_board_ptr(0, 2, true) == s.get_board_ptr(0, 2, true));
+    // modifying the original afterwards does not leak into the copy
+    state s1 = s0;
+    flag = s.apply_move(full_move("(1T2)Rc4c2"));
+    assert(flag);
+    assert(s0 == s1 && s0.get_board_ptr(1, 3, false) == nullptr);
+    std::cout << "test_shared_timelines passed" << std::endl;
+}
+
+int main()
+{
+    test_board_hash();
+    test_state_hash();
+    test_shared_timelines();
+    std::cout << "---= test_hash.cpp: all passed =---" << std::endl;
+    return 0;
+}
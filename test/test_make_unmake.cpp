@@ -0,0 +1,98 @@
+#include <iostream>
+#include <cassert>
+#include "state.h"
+#include "transposition_table.h"
+#include "pgnparser.h"
+#include "fixtures.h"
+
+bool same_state(const state &s, const state &t)
+{
+    return s == t && s.hash() == t.hash() && s.get_present() == t.get_present()
+        && s.get_lines_range() == t.get_lines_range() && s.get_active_range() == t.get_active_range()
+        && s.show_fen() == t.show_fen();
+}
+
+/*
+ walk(s, depth, width): make every legal action of `s` in place, compare with can_apply(), recurse
+ into the first `width` of them, and check that unmaking restores `s`. Returns the number of actions made.
+ */
+size_t walk(state &s, int depth, size_t width)
+{
+    if(depth == 0)
+        return 0;
+    const state orig = s;
+    auto e = transposition_table::compute(s, true);
+    size_t n = 0, i = 0;
+    for(const action &act : *e.actions)
+    {
+        std::optional<state> t = s.can_apply(act);
+        assert(t.has_value());
+        [[maybe_unused]] bool flag = s.make_action(act);
+        assert(flag);
+        assert(same_state(s, *t));
+        n += 1 + (i++ < width ? walk(s, depth - 1, width) : 0);
+        s.unmake_action();
+        assert(same_state(s, orig));
+    }
+    return n;
+}
+
+void test_actions()
+{
+    state s(*pgnparser(very_small_open).parse_game());
+    size_t n = walk(s, 3, 4);
+    assert(n > 0 && s.undo_depth() == 0);
+    std::cout << "test_actions passed (" << n << " actions)" << std::endl;
+}
+
+void test_moves()
+{
+    state s(*pgnparser(very_small_open).parse_game());
+    const state orig = s;
+    full_move fm0("(0T2)Rb4b1"), fm1("(1T2)Rc4c2");
+    [[maybe_unused]] bool flag = s.make_move(fm0) && s.make_move(fm1);
+    assert(flag && s.undo_depth() == 2);
+    auto t = orig.can_apply(fm0)->can_apply(fm1);
+    assert(same_state(s, *t));
+    s.unmake_move();
+    assert(same_state(s, *orig.can_apply(fm0)));
+    s.unmake_move();
+    assert(same_state(s, orig) && s.undo_depth() == 0);
+    // a rejected move leaves no entry
+    flag = s.make_move(full_move("(0T2)Rb4a4"));
+    assert(!flag && s.undo_depth() == 0 && same_state(s, orig));
+    // entries must be reverted by the matching function
+    flag = s.make_move(fm0);
+    assert(flag);
+    [[maybe_unused]] bool thrown = false;
+    try {
+        s.unmake_action();
+    } catch (const std::runtime_error&) {
+        thrown = true;
+    }
+    assert(thrown);
+    s.unmake_move();
+    assert(same_state(s, orig));
+    std::cout << "test_moves passed" << std::endl;
+}
+
+void test_failed_action()
+{
+    state s(*pgnparser(very_small_open).parse_game());
+    const state orig = s;
+    // the first move is fine but the action cannot be submitted
+    action act = action::from_vector({ext_move(full_move("(0T2)Rb4b1"))}, s);
+    [[maybe_unused]] bool flag = s.make_action(act);
+    assert(!flag && s.undo_depth() == 0);
+    assert(same_state(s, orig));
+    std::cout << "test_failed_action passed" << std::endl;
+}
+
+int main()
+{
+    test_actions();
+    test_moves();
+    test_failed_action();
+    std::cout << "---= test_make_unmake.cpp: all passed =---" << std::endl;
+    return 0;
+}
@@ -0,0 +1,57 @@
+#include <iostream>
+#include <cassert>
+#include <algorithm>
+#include "hypercuboid.h"
+#include "pgnparser.h"
+#include "fixtures.h"
+
+// number of pieces captured by the action
+int captures(const state &s, const moveseq &mvs)
+{
+    auto [t, c] = s.get_present();
+    int n = 0;
+    for(const full_move &m : mvs)
+    {
+        piece_t p = s.get_piece(m.to, c);
+        n += p != NO_PIECE && p != WALL_PIECE;
+    }
+    return n;
+}
+
+void test_same_actions(const std::string &pgn)
+{
+    state s(*pgnparser(pgn).parse_game());
+    auto [t, c] = s.get_present();
+    semimove_scorer scorer = [&s, c](const semimove &loc) {
+        const full_move *m = std::holds_alternative<physical_move>(loc) ? &std::get<physical_move>(loc).m
+                           : std::holds_alternative<arriving_move>(loc) ? &std::get<arriving_move>(loc).m : nullptr;
+        if(m == nullptr)
+            return 0;
+        piece_t p = s.get_piece(m->to, c);
+        return static_cast<int>(p != NO_PIECE && p != WALL_PIECE);
+    };
+    auto [w, ss] = HC_info::build_HC(s);
+    std::vector<moveseq> plain, ordered;
+    for(const moveseq &mvs : w.search(ss))
+        plain.push_back(mvs);
+    for(const moveseq &mvs : w.search(ss, scorer))
+        ordered.push_back(mvs);
+    assert(!ordered.empty());
+    int best = 0;
+    for(const moveseq &mvs : plain)
+        best = std::max(best, captures(s, mvs));
+    // the most capturing action is generated first
+    assert(captures(s, ordered.front()) == best);
+    std::sort(plain.begin(), plain.end());
+    std::sort(ordered.begin(), ordered.end());
+    assert(plain == ordered);
+    std::cout << "test_same_actions passed: " << plain.size() << " actions, first captures " << best << std::endl;
+}
+
+int main()
+{
+    test_same_actions(very_small_open);
+    test_same_actions(turn_zero);
+    std::cout << "---= test_ordered_search.cpp: all passed =---" << std::endl;
+    return 0;
+}
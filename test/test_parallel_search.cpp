@@ -0,0 +1,45 @@
+#include <iostream>
+#include <cassert>
+#include <algorithm>
+#include "hypercuboid.h"
+#include "pgnparser.h"
+#include "fixtures.h"
+
+// checkmate, no legal actions
+std::string mated = R"(
+[Size "4x4"]
+[Board "custom"]
+[Mode "5D"]
+[k3/4/1K2/3R:0:1:w]
+1. Rd4
+)";
+
+void test_parallel(const std::string &pgn)
+{
+    state s(*pgnparser(pgn).parse_game());
+    auto [w, ss] = HC_info::build_HC(s);
+    std::vector<moveseq> sequential;
+    for(const moveseq &mvs : w.search(ss))
+        sequential.push_back(mvs);
+    std::sort(sequential.begin(), sequential.end());
+    for(int threads : {1, 2, 4})
+    {
+        auto [w1, ss1] = HC_info::build_HC(s);
+        std::vector<moveseq> det = w1.search_parallel(ss1, threads, true);
+        assert(det == sequential);
+        std::vector<moveseq> undet = w1.search_parallel(ss1, threads, false);
+        assert(undet.size() == sequential.size());
+        std::sort(undet.begin(), undet.end());
+        assert(undet == sequential);
+    }
+    std::cout << "test_parallel passed: " << sequential.size() << " actions" << std::endl;
+}
+
+int main()
+{
+    test_parallel(very_small_open);
+    test_parallel(turn_zero);
+    test_parallel(mated);
+    std::cout << "---= test_parallel_search.cpp: all passed =---" << std::endl;
+    return 0;
+}
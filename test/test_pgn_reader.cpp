@@ -0,0 +1,167 @@
+#include <iostream>
+#include <sstream>
+#include <fstream>
+#include <filesystem>
+#include <vector>
+#include <string>
+#include <cassert>
+#include "pgn_reader.h"
+#include "pgnparser.h"
+#include "game.h"
+
+std::vector<std::string> games_text = {
+R"([Mode "5D"]
+[Board "Very Small - Open"]
+
+1. Rb4 / Rxb4
+2. N>>d3 / (1T1)Bc3+
+3. (1T2)Nxc3
+)",
+R"([Mode "5D"]
+[Board "Standard - Turn Zero"]
+[Size "8x8"]
+
+1. Nf3 / (0T1)Ng8>>(0T0)g6
+2. (-1T1)Nf3
+)",
+R"(
+{a comment after the moves [not a header]}
+[Size "4x4"]
+[Board "custom"]
+[Mode "5D"]
+[nbrk/3p*/P*3/KRBN:0:1:w]
+
+1. (0T1)Rb1xb4 {a [bracket] inside {a nested} comment} / (0T1)Rc4xb4
+2. (0T2)Bc1>>(0T1)c2 / (1T1)d3d2
+3. (1T2)a2a3
+
+
+)",
+R"([Mode "5D"]
+[Board "Standard"]
+1. e3 / e6
+)",
+};
+
+std::string concatenated()
+{
+    std::string all;
+    for(const std::string &s : games_text)
+        all += s;
+    return all;
+}
+
+// hashes of the final positions, loading each game on its own
+std::vector<uint64_t> expected_hashes()
+{
+    std::vector<uint64_t> hashes;
+    for(const std::string &s : games_text)
+        hashes.push_back(game::from_pgn(s).get_current_state().hash());
+    return hashes;
+}
+
+std::vector<uint64_t> read_hashes(pgn_reader &reader)
+{
+    std::vector<uint64_t> hashes;
+    while(std::optional<pgnparser_ast::game> ag = reader.next())
+        hashes.push_back(game::from_ast(std::move(*ag)).get_current_state().hash());
+    return hashes;
+}
+
+void test_stream()
+{
+    const std::vector<uint64_t> expected = expected_hashes();
+    for(size_t chunk : {size_t(1), size_t(7), size_t(64), pgn_reader::DEFAULT_CHUNK_SIZE})
+    {
+        std::istringstream in(concatenated());
+        pgn_reader reader(in, chunk);
+        [[maybe_unused]] std::vector<uint64_t> hashes = read_hashes(reader);
+        assert(hashes == expected);
+        assert(reader.games_read() == games_text.size());
+        assert(!reader.next().has_value());
+    }
+    std::istringstream empty(" \n\n");
+    pgn_reader reader(empty);
+    assert(!reader.next_text().has_value());
+}
+
+void test_split()
+{
+    std::istringstream in(concatenated());
+    pgn_reader reader(in, 5);
+    // the games cover the input; text between two games belongs to the first one
+    std::string all;
+    while(std::optional<std::string_view> text = reader.next_text())
+    {
+        assert(text->starts_with('['));
+        all += *text;
+    }
+    assert(all == concatenated());
+    assert(reader.games_read() == games_text.size());
+}
+
+void test_mapped_file()
+{
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "test_pgn_reader.5dpgn";
+    {
+        std::ofstream out(path, std::ios::binary);
+        out << concatenated();
+    }
+    pgn_reader reader(path.string());
+    [[maybe_unused]] std::vector<uint64_t> hashes = read_hashes(reader);
+    assert(hashes == expected_hashes());
+    std::filesystem::remove(path);
+}
+
+void test_bad_game()
+{
+    // a broken game does not stop the reader
+    std::istringstream in(games_text[0] + "[Mode \"5D\"]\n1. ((( / \n" + games_text[1]);
+    pgn_reader reader(in, 3);
+    assert(reader.next().has_value());
+    [[maybe_unused]] bool thrown = false;
+    try
+    {
+        reader.next();
+    }
+    catch(const parse_error &)
+    {
+        thrown = true;
+    }
+    assert(thrown);
+    assert(reader.next().has_value());
+    assert(!reader.next().has_value());
+}
+
+void test_headers_only()
+{
+    // a game without moves ends at a blank line before the next headers, or at a repeated key
+    const std::string headers_only = "[Mode \"5D\"]\n[Board \"Standard\"]\n";
+    for(const std::string &separator : {std::string("\n"), std::string("")})
+    {
+        std::istringstream in(headers_only + separator + games_text[0]);
+        pgn_reader reader(in, 4);
+        [[maybe_unused]] std::vector<uint64_t> hashes = read_hashes(reader);
+        assert(hashes.size() == 2);
+        assert(hashes[0] == game::from_pgn(headers_only).get_current_state().hash());
+        assert(hashes[1] == expected_hashes()[0]);
+        assert(reader.games_read() == 2);
+    }
+    // board lines after a blank line stay in their game
+    std::istringstream in(games_text[2].substr(0, games_text[2].find("[nbrk")) + "\n"
+                          + games_text[2].substr(games_text[2].find("[nbrk")));
+    pgn_reader reader(in, 4);
+    [[maybe_unused]] std::vector<uint64_t> hashes = read_hashes(reader);
+    assert(hashes == std::vector<uint64_t>{expected_hashes()[2]});
+}
+
+int main()
+{
+    test_stream();
+    test_split();
+    test_mapped_file();
+    test_bad_game();
+    test_headers_only();
+    std::cout << "---= test_pgn_reader.cpp: all passed =---" << std::endl;
+    return 0;
+}
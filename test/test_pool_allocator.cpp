@@ -0,0 +1,63 @@
+#include <iostream>
+#include <cassert>
+#include <vector>
+#include <thread>
+#include <memory>
+#include "board.h"
+#include "pool_allocator.h"
+
+void test_replace_pieces()
+{
+    board b("r*nbqk*bnr*/p*p*p*p*p*p*p*p*/8/8/8/8/P*P*P*P*P*P*P*P*/R*NBQK*BNR*");
+    // one copy gives the same board as chained edits
+    auto c = b.move_piece(ppos(7,0), ppos(5,0))->move_piece(ppos(4,0), ppos(6,0));
+    auto d = b.replace_pieces({
+        {ppos(5,0), b.get_piece(ppos(7,0))},
+        {ppos(7,0), NO_PIECE},
+        {ppos(6,0), b.get_piece(ppos(4,0))},
+        {ppos(4,0), NO_PIECE}
+    });
+    assert(*c == *d && c->hash() == d->hash());
+    assert(c->get_fen() == d->get_fen());
+    assert(!(*d == b));
+}
+
+void test_cross_thread()
+{
+    // boards made on one thread are released on others, and blocks of exited threads are reused
+    constexpr int N = 2000;
+    board b("r*nbqk*bnr*/p*p*p*p*p*p*p*p*/8/8/8/8/P*P*P*P*P*P*P*P*/R*NBQK*BNR*");
+    std::vector<std::shared_ptr<board>> made(N);
+    std::thread producer([&]{
+        for(int i = 0; i < N; i++)
+        {
+            made[i] = b.replace_piece(i % 64, i % 2 ? NO_PIECE : QUEEN_W);
+        }
+    });
+    producer.join();
+    std::vector<std::thread> consumers;
+    for(int k = 0; k < 4; k++)
+    {
+        consumers.emplace_back([&, k]{
+            for(int i = k; i < N; i += 4)
+            {
+                assert(made[i]->get_piece(i % 64) == (i % 2 ? NO_PIECE : QUEEN_W));
+                made[i].reset();
+                auto e = make_board(b);
+                assert(*e == b);
+            }
+        });
+    }
+    for(auto &t : consumers)
+        t.join();
+    auto f = make_board(b);
+    assert(*f == b);
+}
+
+int main()
+{
+    test_replace_pieces();
+    test_cross_thread();
+    std::cout << "---= test_pool_allocator.cpp: all passed =---" << std::endl;
+    return 0;
+}
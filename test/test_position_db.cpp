@@ -0,0 +1,151 @@
+#include <iostream>
+#include <cassert>
+#include <fstream>
+#include <filesystem>
+#include "game.h"
+#include "hypercuboid.h"
+#include "position_db.h"
+#include "fixtures.h"
+
+std::string standard_opening =
+R"(
+[Mode "5D"]
+[Board "Standard"]
+1.(0T1)Ng1f3 / (0T1)c7c6 
+2.(0T2)Nf3e5 / (0T2)Ng8>>(0T1)g6 
+3.(-1T2)d2d3 / (-1T2)Nb8c6 
+)";
+
+std::filesystem::path db_path()
+{
+    return std::filesystem::temp_directory_path() / "test_position_db.5ddb";
+}
+
+// every position reached by playing the first legal action a few times
+std::vector<state> some_positions()
+{
+    std::vector<state> positions;
+    for(const std::string &pgn : {very_small_open, standard_opening})
+    {
+        state s = game::from_pgn(pgn).get_current_state();
+        for(int i = 0; i < 4; i++)
+        {
+            positions.push_back(s);
+            auto [w, ss] = HC_info::build_HC(s);
+            std::optional<moveseq> mvs = w.search(ss).first();
+            if(!mvs)
+                break;
+            std::vector<ext_move> emvs(mvs->begin(), mvs->end());
+            s = *s.can_apply(action::from_vector(emvs, s));
+        }
+    }
+    return positions;
+}
+
+size_t count_actions(const state &s)
+{
+    auto [w, ss] = HC_info::build_HC(s);
+    size_t n = 0;
+    for([[maybe_unused]] const moveseq &mvs : w.search(ss))
+        n++;
+    return n;
+}
+
+void test_store_and_reopen()
+{
+    std::filesystem::remove(db_path());
+    std::vector<state> positions = some_positions();
+    {
+        position_db db(db_path().string());
+        assert(db.size() == 0);
+        for(const state &s : positions)
+        {
+            assert(!db.lookup(s).has_value());
+            position_db::entry e = db.query(s);
+            assert(e.status == transposition_table::compute(s).status);
+            assert(e.best.has_value() == (e.status == match_status_t::PLAYING));
+            if(e.best)
+                assert(s.can_apply(*e.best).has_value());
+            [[maybe_unused]] std::optional<position_db::entry> f = db.lookup(s);
+            assert(f && f->status == e.status && f->best == e.best);
+        }
+        assert(db.size() == positions.size());
+    }
+    {
+        // reopen: the records are read from the mapped file
+        position_db db(db_path().string());
+        assert(db.size() == positions.size());
+        for(const state &s : positions)
+        {
+            [[maybe_unused]] std::optional<position_db::entry> e = db.lookup(s);
+            assert(e.has_value() && !e->legal_actions.has_value());
+            // counting the actions supersedes the first record
+            position_db::entry f = db.query(s, true);
+            assert(f.legal_actions == count_actions(s));
+            assert(db.lookup(s)->legal_actions == f.legal_actions);
+        }
+        assert(db.size() == 2 * positions.size());
+    }
+    {
+        position_db db(db_path().string());
+        for([[maybe_unused]] const state &s : positions)
+        {
+            assert(db.lookup(s)->legal_actions == count_actions(s));
+        }
+    }
+}
+
+void test_truncated()
+{
+    std::vector<state> positions = some_positions();
+    [[maybe_unused]] size_t n;
+    {
+        position_db db(db_path().string());
+        n = db.size();
+    }
+    // simulate a crash in the middle of an append: a record announcing 64 bytes, of which only
+    // the hash and a few more were written
+    {
+        const char torn[] = "\x40\x00\x00\x00" "\x01\x02\x03\x04\x05\x06\x07\x08" "garbage";
+        std::ofstream out(db_path(), std::ios::binary | std::ios::app);
+        out.write(torn, sizeof torn - 1);
+    }
+    {
+        position_db db(db_path().string());
+        assert(db.size() == n);
+        db.store(positions[0], position_db::entry{match_status_t::STALEMATE, std::nullopt, 0});
+    }
+    position_db db(db_path().string());
+    assert(db.size() == n + 1);
+    assert(db.lookup(positions[0])->status == match_status_t::STALEMATE);
+    assert(db.lookup(positions[1]).has_value());
+    std::filesystem::remove(db_path());
+}
+
+void test_bad_file()
+{
+    {
+        std::ofstream out(db_path(), std::ios::binary | std::ios::trunc);
+        out << "not a database";
+    }
+    [[maybe_unused]] bool thrown = false;
+    try
+    {
+        position_db db(db_path().string());
+    }
+    catch(const std::runtime_error &)
+    {
+        thrown = true;
+    }
+    assert(thrown);
+    std::filesystem::remove(db_path());
+}
+
+int main()
+{
+    test_store_and_reopen();
+    test_truncated();
+    test_bad_file();
+    std::cout << "---= test_position_db.cpp: all passed =---" << std::endl;
+    return 0;
+}
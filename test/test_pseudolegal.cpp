@@ -0,0 +1,110 @@
+#include <iostream>
+#include <cassert>
+#include <set>
+#include "game.h"
+#include "hypercuboid.h"
+#include "fixtures.h"
+
+/*
+ compare is_pseudolegal() against the generated moves for every piece of the player to move
+ on the end of each timeline and every square of every board
+ */
+void check_state(const state &s)
+{
+    auto [present, player] = s.get_present();
+    auto [l_min, l_max] = s.get_lines_range();
+    auto [size_x, size_y] = s.get_board_size();
+    int tested = 0;
+    for(int l = l_min; l <= l_max; l++)
+    {
+        auto [t, c] = s.get_timeline_end(l);
+        if(c != player)
+            continue;
+        std::shared_ptr<board> b_ptr = s.get_board(l, t, c);
+        bitboard_t pieces = (c ? b_ptr->friendly<true>() : b_ptr->friendly<false>()) & ~b_ptr->wall();
+        for(int pos : marked_pos(pieces))
+        {
+            vec4 p(pos, vec4(0, 0, t, l));
+            std::set<vec4> moves;
+            for(vec4 q : s.gen_piece_move(p, c))
+            {
+                moves.insert(q);
+            }
+            for(int l1 = l_min; l1 <= l_max; l1++)
+            {
+                auto [t0, c0] = s.get_timeline_start(l1);
+                auto [t1, c1] = s.get_timeline_end(l1);
+                for(int t2 = t0 - 1; t2 <= t1 + 1; t2++)
+                {
+                    for(int y = 0; y < size_y; y++)
+                    {
+                        for(int x = 0; x < size_x; x++)
+                        {
+                            vec4 q(x, y, t2, l1);
+                            bool expected = moves.contains(q);
+                            bool actual = s.is_pseudolegal(full_move(p, q));
+                            if(expected != actual)
+                            {
+                                std::cerr << "mismatch on " << full_move(p, q) << ": expected " << expected << "\n" << s.to_string();
+                            }
+                            assert(expected == actual);
+                            tested += expected;
+                        }
+                    }
+                }
+            }
+        }
+    }
+    assert(tested > 0);
+}
+
+// check a few positions following the game
+void check_game(const std::string &pgn, int plies)
+{
+    for(const state &s : following_positions(pgn, plies))
+    {
+        check_state(s);
+    }
+}
+
+/*
+ compound slides reach the farthest square of the board, however small it is:
+ on 5x5, the queen on a1 slides 4 steps diagonally while going 4 turns back
+ */
+void test_compound_reach()
+{
+    game g = game::from_pgn(R"(
+[Size "5x5"]
+[Board "custom"]
+[Mode "5D"]
+[k4/5/5/5/Q3K:0:1:w]
+
+1. Kd1 / Kb5
+2. Ke1 / Ka5
+3. Kd1 / Kb5
+4. Ke1 / Ka5
+)");
+    const state &s = g.get_current_state();
+    std::set<vec4> moves;
+    for(vec4 q : s.gen_piece_move(vec4(0, 0, 5, 0), false))
+    {
+        moves.insert(q);
+    }
+    for(int n = 1; n <= 4; n++)
+    {
+        assert(moves.contains(vec4(n, n, 5 - n, 0)));
+        assert(moves.contains(vec4(0, n, 5 - n, 0)));
+    }
+    check_state(s);
+}
+
+int main()
+{
+    check_game(very_small_open, 4);
+    check_game(just_unicorns, 4);
+    check_game(fairy_pieces, 6);
+    check_game(standard_branching, 2);
+    test_compound_reach();
+    std::cout << "---= test_pseudolegal.cpp: all passed =---" << std::endl;
+    return 0;
+}
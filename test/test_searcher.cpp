@@ -0,0 +1,76 @@
+#include <iostream>
+#include <cassert>
+#include "searcher.h"
+#include "hypercuboid.h"
+#include "pgnparser.h"
+#include "fixtures.h"
+
+// white mates with Rd4
+std::string mate_in_one = R"(
+[Size "4x4"]
+[Board "custom"]
+[Mode "5D"]
+[k3/4/1K2/3R:0:1:w]
+)";
+
+bool has_action(const state &s)
+{
+    auto [w, ss] = HC_info::build_HC(s);
+    return w.search(ss).first().has_value();
+}
+
+void test_mate_in_one()
+{
+    state s(*pgnparser(mate_in_one).parse_game());
+    searcher sr;
+    searcher::limits lim;
+    lim.max_depth = 2;
+    auto res = sr.search(s, lim);
+    assert(res.score == searcher::MATE_SCORE - 1);
+    assert(res.depth == 1 && res.pv.size() == 1);
+    std::optional<state> t = s.can_apply(res.pv[0]);
+    assert(t.has_value() && !has_action(*t));
+    std::cout << "test_mate_in_one passed: " << s.pretty_action(res.pv[0]) << std::endl;
+}
+
+void test_limits()
+{
+    state s(*pgnparser(very_small_open).parse_game());
+    searcher sr;
+    searcher::limits lim;
+    lim.max_depth = 2;
+    lim.actions_per_node = 8;
+    auto full = sr.search(s, lim);
+    assert(full.depth == 2 && !full.pv.empty());
+    // the pv consists of legal actions
+    state t = s;
+    for(const action &act : full.pv)
+    {
+        std::optional<state> u = t.can_apply(act);
+        assert(u.has_value());
+        t = *u;
+    }
+    // with a node limit the search stops early but still returns an action
+    searcher sr2;
+    lim.max_depth = 10;
+    lim.nodes = 50;
+    auto part = sr2.search(s, lim);
+    assert(part.depth < 10 && !part.pv.empty());
+    assert(part.nodes >= 50 && part.nodes < 50 + 100);
+    // custom evaluation function
+    int calls = 0;
+    searcher sr3([&calls](const state &) { calls++; return 0; });
+    lim.max_depth = 1;
+    lim.nodes = 0;
+    auto zero = sr3.search(s, lim);
+    assert(zero.score == 0 && calls > 0);
+    std::cout << "test_limits passed" << std::endl;
+}
+
+int main()
+{
+    test_mate_in_one();
+    test_limits();
+    std::cout << "---= test_searcher.cpp: all passed =---" << std::endl;
+    return 0;
+}
@@ -0,0 +1,100 @@
+#include <iostream>
+#include <cassert>
+#include <string>
+#include <vector>
+#include <cstring>
+#include "game.h"
+#include "hypercuboid.h"
+#include "fixtures.h"
+
+void check_round_trip(const state &s)
+{
+    std::string data = s.serialize();
+    state t = state::deserialize(data);
+    assert(t == s);
+    assert(t.hash() == s.hash());
+    assert(t.get_present() == s.get_present());
+    assert(t.get_active_range() == s.get_active_range());
+    assert(t.get_initial_lines_range() == s.get_initial_lines_range());
+    assert(t.get_boards() == s.get_boards());
+    assert(t.serialize() == data);
+    // the positions after a move agree as well
+    [[maybe_unused]] bool player = s.get_present().second;
+    assert(t.phantom().first_check(!player) == s.phantom().first_check(!player));
+}
+
+void test_round_trip()
+{
+    for(const std::string &pgn : {very_small_open, fairy_pieces, standard_branching})
+    {
+        game g = game::from_pgn(pgn);
+        check_round_trip(g.get_current_state());
+        // a state in the middle of a turn, whose present differs from the one of its multiverse
+        state s = g.get_current_state();
+        auto [w, ss] = HC_info::build_HC(s);
+        if(std::optional<moveseq> mvs = w.search(ss).first(); mvs && !mvs->empty())
+        {
+            [[maybe_unused]] bool ok = s.apply_move((*mvs)[0]);
+            assert(ok);
+            check_round_trip(s);
+        }
+    }
+}
+
+uint32_t stored_boards(const std::string &data)
+{
+    // after the state header (16 bytes) and the multiverse header (20 bytes)
+    uint32_t n;
+    std::memcpy(&n, data.data() + 16 + 20, sizeof(n));
+    return n;
+}
+
+void test_shared_boards()
+{
+    // the two initial timelines start with equal boards, which are shared once interned
+    state s = game::from_pgn(fairy_pieces).get_current_state();
+    [[maybe_unused]] uint32_t distinct = stored_boards(s.serialize());
+    assert(distinct == s.get_boards().size());
+    state t = game::from_pgn(fairy_pieces, std::make_shared<board_interner>()).get_current_state();
+    std::string data = t.serialize();
+    assert(stored_boards(data) == distinct - 1);
+    state u = state::deserialize(data);
+    assert(u.get_board(0, 1, false) == u.get_board(-1, 1, false));
+    assert(u == s);
+}
+
+void test_malformed()
+{
+    state s = game::from_pgn(very_small_open).get_current_state();
+    std::string data = s.serialize();
+    [[maybe_unused]] auto rejects = [](std::string_view bad) {
+        try
+        {
+            state::deserialize(bad);
+        }
+        catch(const std::runtime_error &)
+        {
+            return true;
+        }
+        return false;
+    };
+    for(size_t n = 0; n < data.size(); n++)
+    {
+        assert(rejects(std::string_view(data).substr(0, n)));
+    }
+    std::string bad_magic = data;
+    bad_magic[0] = 'X';
+    assert(rejects(bad_magic));
+    std::string bad_version = data;
+    bad_version[4]++;
+    assert(rejects(bad_version));
+}
+
+int main()
+{
+    test_round_trip();
+    test_shared_boards();
+    test_malformed();
+    std::cout << "---= test_serialization.cpp: all passed =---" << std::endl;
+    return 0;
+}
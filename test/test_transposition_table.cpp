@@ -0,0 +1,105 @@
+#include <iostream>
+#include <cassert>
+#include "game.h"
+#include "transposition_table.h"
+#include "pgnparser.h"
+#include "fixtures.h"
+
+void test_query()
+{
+    state s(*pgnparser(very_small_open).parse_game());
+    transposition_table tt;
+    auto e0 = tt.query(s);
+    assert(e0.status == match_status_t::PLAYING);
+    assert(e0.first_action.has_value() && !e0.actions.has_value());
+    assert(tt.size() == 1 && tt.get_misses() == 1 && tt.get_hits() == 0);
+    auto e1 = tt.query(s);
+    assert(e1.first_action == e0.first_action);
+    assert(tt.get_hits() == 1);
+    // asking for the full list recomputes once
+    auto e2 = tt.query(s, true);
+    assert(e2.actions.has_value() && !e2.actions->empty());
+    assert(e2.actions->front() == *e0.first_action);
+    auto e3 = tt.query(s, true);
+    assert(e3.actions->size() == e2.actions->size());
+    assert(tt.size() == 1 && tt.get_hits() == 3);
+    std::cout << "test_query passed" << std::endl;
+}
+
+void test_eviction()
+{
+    transposition_table::entry e{match_status_t::STALEMATE, std::nullopt, std::nullopt};
+    // one shard, room for a few entries only
+    transposition_table lru(1024, transposition_table::policy::LRU, 1);
+    transposition_table fifo(1024, transposition_table::policy::FIFO, 1);
+    for(transposition_table *tt : {&lru, &fifo})
+    {
+        tt->store(0, "0", e);
+        for(uint64_t key = 1; key < 100; key++)
+        {
+            // keep touching key 0
+            tt->lookup(0, "0");
+            tt->store(key, std::to_string(key), e);
+            assert(tt->memory_usage() <= tt->get_budget());
+        }
+        assert(tt->size() > 1 && tt->size() < 100);
+        assert(tt->lookup(99, "99").has_value());
+    }
+    assert(lru.lookup(0, "0").has_value());
+    assert(!fifo.lookup(0, "0").has_value());
+    lru.clear();
+    assert(lru.size() == 0 && lru.memory_usage() == 0);
+    std::cout << "test_eviction passed" << std::endl;
+}
+
+void test_collision()
+{
+    // entries are verified against the state, not only the hash
+    transposition_table tt;
+    transposition_table::entry e{match_status_t::STALEMATE, std::nullopt, std::nullopt};
+    tt.store(1, "a", e);
+    assert(tt.lookup(1, "a").has_value());
+    assert(!tt.lookup(1, "b").has_value());
+    state s(*pgnparser(very_small_open).parse_game());
+    tt.store(s.hash(), "another state", e);
+    assert(tt.query(s).status == match_status_t::PLAYING);
+    assert(tt.query(s).status == match_status_t::PLAYING);
+    assert(tt.size() == 2);
+    std::cout << "test_collision passed" << std::endl;
+}
+
+void test_game()
+{
+    game g = game::from_pgn(very_small_open);
+    auto tt = g.get_transposition_table();
+    assert(tt != nullptr);
+    assert(g.get_match_status() == match_status_t::PLAYING);
+    [[maybe_unused]] size_t misses = tt->get_misses();
+    assert(g.get_match_status() == match_status_t::PLAYING);
+    assert(tt->get_misses() == misses);
+    [[maybe_unused]] bool flag = g.suggest_action();
+    assert(flag);
+    flag = g.suggest_action();
+    assert(flag);
+    assert(g.get_child_moves().size() == 2);
+    // same behavior without a table
+    game h = game::from_pgn(very_small_open);
+    h.set_transposition_table(nullptr);
+    assert(h.get_match_status() == match_status_t::PLAYING);
+    flag = h.suggest_action();
+    assert(flag);
+    flag = h.suggest_action();
+    assert(flag);
+    assert(h.get_child_moves() == g.get_child_moves());
+    std::cout << "test_game passed" << std::endl;
+}
+
+int main()
+{
+    test_query();
+    test_eviction();
+    test_collision();
+    test_game();
+    std::cout << "---= test_transposition_table.cpp: all passed =---" << std::endl;
+    return 0;
+}